@@ -56,6 +56,7 @@
 
 #include "base.h"
 #include "binary_io.h"
+#include "crc.h"
 #include "proc_menu.h"
 
 extern mode_configuration_t mode_configuration;
@@ -72,6 +73,15 @@ extern command_t last_command;
 #error "BP_1WIRE_DEVICE_DEV_ROSTER_SLOTS too big"
 #endif /* BP_1WIRE_DEVICE_DEV_ROSTER_SLOTS > MAXIMUM_DEVICES_ROSTER_SIZE */
 
+/**
+ * @brief How many times a ROM search pass is attempted before giving up.
+ *
+ * A pass whose ROM number fails the CRC check is repeated along the same
+ * search path, so that a single disturbed pass does not cut short the
+ * enumeration of the remaining devices.
+ */
+#define ONEWIRE_SEARCH_ATTEMPTS 3
+
 /**
  * @brief Size of a 1-Wire ROM number identifier, in bytes.
  */
@@ -112,6 +122,42 @@ extern command_t last_command;
  */
 #define DS2431 0x2D
 
+/**
+ * @brief Size of a DS18x20 thermometer scratchpad, CRC byte included.
+ */
+#define SCRATCHPAD_BYTES_SIZE 9
+
+/**
+ * @brief Maximum time to wait for a DS18x20 temperature conversion, in
+ * milliseconds.
+ *
+ * This is the worst case conversion time at 12 bits of resolution.
+ */
+#define TEMPERATURE_CONVERSION_TIMEOUT_MS 750
+
+/**
+ * @brief DS18x20 function command to start a temperature conversion.
+ */
+#define DS18X20_CONVERT_T 0x44
+
+/**
+ * @brief DS18x20 function command to read the device scratchpad.
+ */
+#define DS18X20_READ_SCRATCHPAD 0xBE
+
+/**
+ * @brief DS18x20 function command to query parasitic power usage.
+ */
+#define DS18X20_READ_POWER_SUPPLY 0xB4
+
+/**
+ * @brief Converts the given amount of microseconds into instruction cycles.
+ *
+ * @param[in] microseconds the amount of microseconds to convert.
+ */
+#define ONEWIRE_US_TO_CYCLES(microseconds)                                     \
+  ((uint16_t)((microseconds) * (FCY / 1000000UL)))
+
 /**
  * @brief Binary I/O 1-Wire Action command.
  *
@@ -133,8 +179,8 @@ extern command_t last_command;
  * * `0b0111` : Reserved.
  * * `0b1000` : BINARY_IO_ONEWIRE_ACTION_ROM_SEARCH_MACRO.
  * * `0b1001` : BINARY_IO_ONEWIRE_ACTION_ALARM_SEARCH_MACRO.
- * * `0b1010` : Reserved.
- * * `0b1011` : Reserved.
+ * * `0b1010` : BINARY_IO_ONEWIRE_ACTION_ROSTER_CONVERT_READ.
+ * * `0b1011` : BINARY_IO_ONEWIRE_ACTION_OVERDRIVE_SKIP_ROM.
  * * `0b1100` : Reserved.
  * * `0b1101` : Reserved.
  * * `0b1110` : Reserved.
@@ -147,6 +193,8 @@ extern command_t last_command;
  * @see BINARY_IO_ONEWIRE_ACTION_READ_BYTE
  * @see BINARY_IO_ONEWIRE_ACTION_ROM_SEARCH_MACRO
  * @see BINARY_IO_ONEWIRE_ACTION_ALARM_SEARCH_MACRO
+ * @see BINARY_IO_ONEWIRE_ACTION_ROSTER_CONVERT_READ
+ * @see BINARY_IO_ONEWIRE_ACTION_OVERDRIVE_SKIP_ROM
  */
 #define BINARY_IO_ONEWIRE_COMMAND_ACTION 0x00
 
@@ -429,6 +477,66 @@ extern command_t last_command;
  */
 #define BINARY_IO_ONEWIRE_ACTION_ALARM_SEARCH_MACRO 0x09
 
+/**
+ * @brief Binary I/O 1-Wire Action command to convert and read all the
+ * thermometers in the device roster.
+ *
+ * The device roster is filled by either the ROM search or the ALARM search
+ * actions.  This action will start a temperature conversion on all devices at
+ * once, wait for the conversion to finish, and then read the scratchpad of
+ * every DS18S20, DS1822, and DS18B20 device in the roster.  Each device is
+ * reported as an 18 bytes record made of its ROM address (8 bytes), its
+ * scratchpad contents (9 bytes), and a status byte set to SUCCESS if the
+ * scratchpad CRC matched or to FAILURE otherwise.  If the bus could not be
+ * reset, or if there are no thermometers in the roster, a FAILURE value is
+ * returned instead and no records are sent.
+ *
+ * Current format is as follows:
+ *
+ * <table><tr><th>Bits</th><th>Meaning</th></tr>
+ * <tr><td>`7:4`</td><td>Command type, set to `0b0000` (ACTION).</td></tr>
+ * <tr><td>`3:0`</td><td>Action type, set to `0b1010` (ROSTER_CONVERT_READ).
+ * </td></tr></table>
+ *
+ * Interaction flow is as follows:
+ *
+ * <table><tr><td>PC</td><td>&rarr;</td><td>Bus Pirate</td>
+ * <td>`0b00001010`</td></tr>
+ * <tr><td>PC</td><td>&larr;</td><td>Bus Pirate</td>
+ * <td>`0b00000001` (SUCCESS).</td></tr>
+ * <tr><td>PC</td><td>&larr;</td><td>Bus Pirate</td>
+ * <td>Number of records to follow.</td></tr>
+ * <tr><td>PC</td><td>&larr;</td><td>Bus Pirate</td>
+ * <td>Device records, 18 bytes each.</td></tr></table>
+ */
+#define BINARY_IO_ONEWIRE_ACTION_ROSTER_CONVERT_READ 0x0A
+
+/**
+ * @brief Binary I/O 1-Wire Action command to switch all devices on the bus to
+ * overdrive speed.
+ *
+ * This action performs a standard speed bus reset, sends an Overdrive Skip
+ * ROM command to all devices, and then switches the board to overdrive speed
+ * as well.  The board will respond with a SUCCESS value if any device answered
+ * the reset pulse, or with a FAILURE value otherwise - in which case the board
+ * is left at standard speed.
+ *
+ * Current format is as follows:
+ *
+ * <table><tr><th>Bits</th><th>Meaning</th></tr>
+ * <tr><td>`7:4`</td><td>Command type, set to `0b0000` (ACTION).</td></tr>
+ * <tr><td>`3:0`</td><td>Action type, set to `0b1011` (OVERDRIVE_SKIP_ROM).
+ * </td></tr></table>
+ *
+ * Interaction flow is as follows:
+ *
+ * <table><tr><td>PC</td><td>&rarr;</td><td>Bus Pirate</td>
+ * <td>`0b00001011`</td></tr>
+ * <tr><td>PC</td><td>&larr;</td><td>Bus Pirate</td>
+ * <td>`0b00000001` (SUCCESS) or `0b00000000` (FAILURE).</td></tr></table>
+ */
+#define BINARY_IO_ONEWIRE_ACTION_OVERDRIVE_SKIP_ROM 0x0B
+
 /**
  * @brief 1-Wire protocol macro identifiers.
  */
@@ -439,9 +547,18 @@ typedef enum {
   /** Identifier for the "Read ROM" macro entry. */
   MACRO_READ_ROM = 0x33,
 
+  /** Identifier for the "Convert and read roster thermometers" macro entry. */
+  MACRO_ROSTER_CONVERT_READ = 0x44,
+
+  /** Identifier for the "Overdrive Skip ROM" macro entry. */
+  MACRO_OVERDRIVE_SKIP_ROM = 0x3C,
+
   /** Identifier for the "Match ROM" macro entry. */
   MACRO_MATCH_ROM = 0x55,
 
+  /** Identifier for the "Overdrive Match ROM" macro entry. */
+  MACRO_OVERDRIVE_MATCH_ROM = 0x69,
+
   /** Identifier for the "Skip ROM" macro entry. */
   MACRO_SKIP_ROM = 0xCC,
 
@@ -532,6 +649,22 @@ typedef enum {
 
 } onewire_bus_reset_result_t;
 
+/**
+ * @brief Possible results from a single ROM search pass.
+ */
+typedef enum {
+
+  /** A device was found and its ROM number CRC matched. */
+  ONEWIRE_SEARCH_PASS_FOUND = 0,
+
+  /** No device answered the search. */
+  ONEWIRE_SEARCH_PASS_NO_DEVICE,
+
+  /** The pass was disturbed, and can be repeated with the same path. */
+  ONEWIRE_SEARCH_PASS_CORRUPTED
+
+} onewire_search_pass_result_t;
+
 /**
  * @brief 1-Wire protocol internal state variables container.
  */
@@ -565,7 +698,7 @@ typedef struct {
   /**
    * Device roster slots.
    */
-  uint8_t roster_entries[ROM_BYTES_SIZE][BP_1WIRE_DEVICE_DEV_ROSTER_SLOTS];
+  uint8_t roster_entries[BP_1WIRE_DEVICE_DEV_ROSTER_SLOTS][ROM_BYTES_SIZE];
 
   /**
    * The command byte to send on the bus.
@@ -595,41 +728,124 @@ typedef struct {
 static onewire_state_t onewire_state = {.command_byte = MACRO_SEARCH_ROM};
 
 /**
- * @brief Performs a 1-Wire bus reset according to the protocol specifications.
+ * @brief 1-Wire bus timings for a given speed, in instruction cycles.
  *
- * @return an appropriate state from onewire_bus_reset_result_t describing
- * the operation result.
+ * Field names refer to the parameters described in AN126, at
+ * https://www.maximintegrated.com/en/app-notes/index.mvp/id/126 - values are
+ * the nominal ones from the application note.  The few cycles spent driving
+ * the I/O lines between the delays are not subtracted, and lengthen each
+ * phase slightly.  A value of zero means that no delay is needed.
  */
-static onewire_bus_reset_result_t perform_bus_reset(void);
+typedef struct {
+
+  /** Delay before pulling the line LOW for a bus reset (G). */
+  uint16_t reset_setup;
+
+  /** Time the line is held LOW for a bus reset (H). */
+  uint16_t reset_low;
+
+  /** Time to wait before sampling for a presence pulse (I). */
+  uint16_t reset_presence_sample;
+
+  /** Time to wait for the end of the presence pulse (J). */
+  uint16_t reset_recovery;
+
+  /** Time the line is held LOW at the start of a slot (A). */
+  uint16_t slot_start;
+
+  /** Time to wait before sampling a read slot (E). */
+  uint16_t read_sample;
+
+  /** Time to wait after sampling a read slot (F). */
+  uint16_t read_recovery;
+
+  /** Time the line is held LOW for a write zero slot (C). */
+  uint16_t write_zero_low;
+
+  /** Time to wait after releasing a write zero slot (D). */
+  uint16_t write_zero_recovery;
+
+  /** Padding added at the end of every slot. */
+  uint16_t slot_padding;
+
+  /** Padding added at the end of every byte. */
+  uint16_t byte_padding;
+
+} onewire_timings_t;
+
+/**
+ * @brief 1-Wire bus timings, indexed by mode_configuration.speed.
+ */
+static const onewire_timings_t ONEWIRE_TIMINGS[] = {
+    /* Standard speed. */
+    {.reset_setup = 0,
+     .reset_low = ONEWIRE_US_TO_CYCLES(500),
+     .reset_presence_sample = ONEWIRE_US_TO_CYCLES(65),
+     .reset_recovery = ONEWIRE_US_TO_CYCLES(500),
+     .slot_start = ONEWIRE_US_TO_CYCLES(4),
+     .read_sample = ONEWIRE_US_TO_CYCLES(8),
+     .read_recovery = ONEWIRE_US_TO_CYCLES(32),
+     .write_zero_low = ONEWIRE_US_TO_CYCLES(25),
+     .write_zero_recovery = ONEWIRE_US_TO_CYCLES(7),
+     .slot_padding = ONEWIRE_US_TO_CYCLES(5),
+     .byte_padding = ONEWIRE_US_TO_CYCLES(8)},
+
+    /* Overdrive speed. */
+    {.reset_setup = ONEWIRE_US_TO_CYCLES(1),
+     .reset_low = ONEWIRE_US_TO_CYCLES(70),
+     .reset_presence_sample = ONEWIRE_US_TO_CYCLES(6),
+     .reset_recovery = ONEWIRE_US_TO_CYCLES(32),
+     .slot_start = ONEWIRE_US_TO_CYCLES(1),
+     .read_sample = 0,
+     .read_recovery = ONEWIRE_US_TO_CYCLES(6),
+     .write_zero_low = ONEWIRE_US_TO_CYCLES(4),
+     .write_zero_recovery = ONEWIRE_US_TO_CYCLES(2),
+     .slot_padding = 0,
+     .byte_padding = 0}};
+
+/**
+ * @brief Bus timings for the currently selected speed.
+ */
+static const onewire_timings_t *onewire_timings = &ONEWIRE_TIMINGS[0];
+
+/**
+ * @brief Waits for the given amount of instruction cycles.
+ *
+ * Cycle counts are taken from ONEWIRE_TIMINGS, so no run-time conversion from
+ * microseconds is needed in the bit slot code paths.
+ *
+ * @param[in] cycles the amount of cycles to wait, zero for no delay.
+ */
+static inline void onewire_delay_cycles(const uint16_t cycles);
 
 /**
- * @brief 1-wire protocol precalculated CRC table.
+ * @brief Switches the board to the given bus speed.
  *
- * Taken from https://www.maximintegrated.com/en/app-notes/index.mvp/id/27
+ * @param[in] speed 0 for standard speed, 1 for overdrive speed.
  */
-static const uint8_t CRC_TABLE[] = {
-    0x00, 0x5E, 0xBC, 0xE2, 0x61, 0x3F, 0xDD, 0x83, 0xC2, 0x9C, 0x7E, 0x20,
-    0xA3, 0xFD, 0x1F, 0x41, 0x9D, 0xC3, 0x21, 0x7F, 0xFC, 0xA2, 0x40, 0x1E,
-    0x5F, 0x01, 0xE3, 0xBD, 0x3E, 0x60, 0x82, 0xDC, 0x23, 0x7D, 0x9F, 0xC1,
-    0x42, 0x1C, 0xFE, 0xA0, 0xE1, 0xBF, 0x5D, 0x03, 0x80, 0xDE, 0x3C, 0x62,
-    0xBE, 0xE0, 0x02, 0x5C, 0xDF, 0x81, 0x63, 0x3D, 0x7C, 0x22, 0xC0, 0x9E,
-    0x1D, 0x43, 0xA1, 0xFF, 0x46, 0x18, 0xFA, 0xA4, 0x27, 0x79, 0x9B, 0xC5,
-    0x84, 0xDA, 0x38, 0x66, 0xE5, 0xBB, 0x59, 0x07, 0xDB, 0x85, 0x67, 0x39,
-    0xBA, 0xE4, 0x06, 0x58, 0x19, 0x47, 0xA5, 0xFB, 0x78, 0x26, 0xC4, 0x9A,
-    0x65, 0x3B, 0xD9, 0x87, 0x04, 0x5A, 0xB8, 0xE6, 0xA7, 0xF9, 0x1B, 0x45,
-    0xC6, 0x98, 0x7A, 0x24, 0xF8, 0xA6, 0x44, 0x1A, 0x99, 0xC7, 0x25, 0x7B,
-    0x3A, 0x64, 0x86, 0xD8, 0x5B, 0x05, 0xE7, 0xB9, 0x8C, 0xD2, 0x30, 0x6E,
-    0xED, 0xB3, 0x51, 0x0F, 0x4E, 0x10, 0xF2, 0xAC, 0x2F, 0x71, 0x93, 0xCD,
-    0x11, 0x4F, 0xAD, 0xF3, 0x70, 0x2E, 0xCC, 0x92, 0xD3, 0x8D, 0x6F, 0x31,
-    0xB2, 0xEC, 0x0E, 0x50, 0xAF, 0xF1, 0x13, 0x4D, 0xCE, 0x90, 0x72, 0x2C,
-    0x6D, 0x33, 0xD1, 0x8F, 0x0C, 0x52, 0xB0, 0xEE, 0x32, 0x6C, 0x8E, 0xD0,
-    0x53, 0x0D, 0xEF, 0xB1, 0xF0, 0xAE, 0x4C, 0x12, 0x91, 0xCF, 0x2D, 0x73,
-    0xCA, 0x94, 0x76, 0x28, 0xAB, 0xF5, 0x17, 0x49, 0x08, 0x56, 0xB4, 0xEA,
-    0x69, 0x37, 0xD5, 0x8B, 0x57, 0x09, 0xEB, 0xB5, 0x36, 0x68, 0x8A, 0xD4,
-    0x95, 0xCB, 0x29, 0x77, 0xF4, 0xAA, 0x48, 0x16, 0xE9, 0xB7, 0x55, 0x0B,
-    0x88, 0xD6, 0x34, 0x6A, 0x2B, 0x75, 0x97, 0xC9, 0x4A, 0x14, 0xF6, 0xA8,
-    0x74, 0x2A, 0xC8, 0x96, 0x15, 0x4B, 0xA9, 0xF7, 0xB6, 0xE8, 0x0A, 0x54,
-    0xD7, 0x89, 0x6B, 0x35};
+static void onewire_set_speed(const uint8_t speed);
+
+/**
+ * @brief Switches all the devices on the bus to overdrive speed.
+ *
+ * A standard speed reset is issued first, followed by the given overdrive ROM
+ * command.  The board is then switched to overdrive speed.
+ *
+ * @param[in] command either MACRO_OVERDRIVE_SKIP_ROM or
+ * MACRO_OVERDRIVE_MATCH_ROM.
+ *
+ * @return the result of the standard speed bus reset.
+ */
+static onewire_bus_reset_result_t
+onewire_enter_overdrive(const uint8_t command);
+
+/**
+ * @brief Performs a 1-Wire bus reset according to the protocol specifications.
+ *
+ * @return an appropriate state from onewire_bus_reset_result_t describing
+ * the operation result.
+ */
+static onewire_bus_reset_result_t perform_bus_reset(void);
 
 /**
  * @brief Updates the internal CRC8 variable with the given data value.
@@ -680,6 +896,52 @@ static bool device_find_next(void);
  */
 static bool perform_device_search(void);
 
+/**
+ * @brief Performs a single ROM search pass on the bus.
+ *
+ * The search path is taken from the discrepancy state left in onewire_state
+ * by the previous pass, which is only updated if this pass succeeds.
+ *
+ * @return the outcome of the search pass.
+ */
+static onewire_search_pass_result_t perform_search_pass(void);
+
+/**
+ * @brief Checks whether the given family code belongs to a DS18x20
+ * thermometer.
+ *
+ * @param[in] family the family code to check.
+ *
+ * @return true if the device has a DS18x20-compatible scratchpad, false
+ * otherwise.
+ */
+static bool is_roster_thermometer(const uint8_t family);
+
+/**
+ * @brief Starts a temperature conversion on all devices on the bus.
+ *
+ * The conversion is addressed with SKIP ROM, so that all devices in the
+ * roster convert in parallel.  If any device reports being parasitically
+ * powered the full worst-case conversion time is waited, otherwise the bus is
+ * polled until all devices report that the conversion is complete.
+ *
+ * @return true if the conversion was started, false if the bus reset failed.
+ */
+static bool roster_start_conversion(void);
+
+/**
+ * @brief Reads the scratchpad of the given device.
+ *
+ * @param[in] rom_address the ROM address of the device to read.
+ * @param[out] scratchpad the buffer to store the scratchpad contents into,
+ * at least SCRATCHPAD_BYTES_SIZE bytes long.
+ *
+ * @return true if the scratchpad was read and its CRC matched, false
+ * otherwise.
+ */
+static bool roster_read_scratchpad(const uint8_t *rom_address,
+                                   uint8_t *scratchpad);
+
 #ifdef BP_1WIRE_LOOKUP_FAMILY_ID
 
 /**
@@ -743,6 +1005,9 @@ void onewire_setup_execute(void) {
   /* Set up pins. */
   ONEWIRE_DATA_DIRECTION = INPUT;
   ONEWIRE_DATA_LINE = LOW;
+
+  /* Load the bus timings for the selected speed. */
+  onewire_set_speed(mode_configuration.speed);
 }
 
 void print_device_information(const size_t roster_id,
@@ -876,6 +1141,49 @@ void onewire_run_macro(const uint16_t macro) {
     break;
   }
 
+  case MACRO_ROSTER_CONVERT_READ: {
+    uint8_t scratchpad[SCRATCHPAD_BYTES_SIZE];
+    size_t index;
+    size_t scratchpad_index;
+
+    MSG_1WIRE_ROSTER_CONVERT_MACRO_NAME;
+
+    if (onewire_state.used_roster_entries == 0) {
+      MSG_1WIRE_NO_DEVICE;
+      break;
+    }
+
+    if (!roster_start_conversion()) {
+      MSG_1WIRE_NO_DEVICE_DETECTED;
+      bpBR;
+      break;
+    }
+
+    for (index = 0; index < onewire_state.used_roster_entries; index++) {
+      if (!is_roster_thermometer(onewire_state.roster_entries[index][0])) {
+        continue;
+      }
+
+      bpSP;
+      bp_write_dec_byte(index + 1);
+      bp_write_string(". ");
+
+      if (roster_read_scratchpad(onewire_state.roster_entries[index],
+                                 scratchpad)) {
+        for (scratchpad_index = 0; scratchpad_index < SCRATCHPAD_BYTES_SIZE;
+             scratchpad_index++) {
+          bp_write_formatted_integer(scratchpad[scratchpad_index]);
+          bpSP;
+        }
+        BPMSG1185;
+      } else {
+        MSG_1WIRE_SCRATCHPAD_CRC_ERROR;
+      }
+    }
+
+    break;
+  }
+
   case MACRO_READ_ROM: {
     uint8_t device_address[ROM_BYTES_SIZE];
     size_t index;
@@ -905,6 +1213,20 @@ void onewire_run_macro(const uint16_t macro) {
     ONEWIRE_WRITE_BYTE(MACRO_SKIP_ROM);
     break;
 
+  case MACRO_OVERDRIVE_SKIP_ROM:
+  case MACRO_OVERDRIVE_MATCH_ROM:
+    if (onewire_enter_overdrive(macro_id) != ONEWIRE_BUS_RESET_OK) {
+      MSG_1WIRE_NO_DEVICE_DETECTED;
+      bpBR;
+      break;
+    }
+    if (macro_id == MACRO_OVERDRIVE_SKIP_ROM) {
+      MSG_1WIRE_OVERDRIVE_SKIP_ROM_MACRO_NAME;
+    } else {
+      MSG_1WIRE_OVERDRIVE_MATCH_ROM_MACRO_NAME;
+    }
+    break;
+
   default:
     MSG_UNKNOWN_MACRO_ERROR;
     break;
@@ -942,10 +1264,8 @@ onewire_bus_reset_result_t perform_bus_reset(void) {
   /* Pull the bus line LOW. */
 
   ONEWIRE_DATA_DIRECTION = INPUT;
-  if (mode_configuration.speed == 1) {
-    /* AN126: Parameter G */
-    bp_delay_us(1);
-  }
+  /* AN126: Parameter G */
+  onewire_delay_cycles(onewire_timings->reset_setup);
   ONEWIRE_DATA_LINE = LOW;
   ONEWIRE_DATA_DIRECTION = OUTPUT;
 
@@ -954,20 +1274,12 @@ onewire_bus_reset_result_t perform_bus_reset(void) {
    * reading the line in standard mode, or no more than 70us for overdrive.
    * AN126: Parameter H
    */
-  if (mode_configuration.speed == 0) {
-    bp_delay_us(500);
-  } else {
-    bp_delay_us(70);
-  }
+  onewire_delay_cycles(onewire_timings->reset_low);
 
   /* Release the bus. */
   ONEWIRE_DATA_DIRECTION = INPUT;
   /* AN126: Parameter I */
-  if (mode_configuration.speed == 0) {
-    bp_delay_us(65);
-  } else {
-    bp_delay_us(6);
-  }
+  onewire_delay_cycles(onewire_timings->reset_presence_sample);
 
   /* Read the data line. */
   if (ONEWIRE_DATA_LINE) {
@@ -976,11 +1288,7 @@ onewire_bus_reset_result_t perform_bus_reset(void) {
   }
 
   /* AN126: Parameter J */
-  if (mode_configuration.speed == 0) {
-    bp_delay_us(500);
-  } else {
-    bp_delay_us(32);
-  }
+  onewire_delay_cycles(onewire_timings->reset_recovery);
 
   /* Read the data line. */
   if (ONEWIRE_DATA_LINE == LOW) {
@@ -1035,13 +1343,58 @@ bool device_find_first() {
 bool device_find_next(void) { return perform_device_search(); }
 
 bool perform_device_search(void) {
+  uint8_t saved_rom_bytes[ROM_BYTES_SIZE];
+  uint8_t saved_family_discrepancy;
+  uint8_t attempt;
+
+  /* Check if the bus enumeration is still in progress. */
+
+  if (!onewire_state.last_device_flag) {
+
+    /*
+     * The search path up to the last discrepancy is taken from the previous
+     * ROM number, so keep it around in case a pass has to be repeated.
+     */
+
+    memcpy(saved_rom_bytes, onewire_state.rom_bytes, sizeof(saved_rom_bytes));
+    saved_family_discrepancy = onewire_state.last_family_discrepancy;
+
+    for (attempt = 0; attempt < ONEWIRE_SEARCH_ATTEMPTS; attempt++) {
+      switch (perform_search_pass()) {
+      case ONEWIRE_SEARCH_PASS_FOUND:
+        return true;
+
+      case ONEWIRE_SEARCH_PASS_CORRUPTED:
+        memcpy(onewire_state.rom_bytes, saved_rom_bytes,
+               sizeof(saved_rom_bytes));
+        onewire_state.last_family_discrepancy = saved_family_discrepancy;
+        continue;
+
+      case ONEWIRE_SEARCH_PASS_NO_DEVICE:
+      default:
+        break;
+      }
+
+      break;
+    }
+  }
+
+  /* No device was found, so reset search state to a clean slate. */
+
+  onewire_state.last_device_discrepancy = 0;
+  onewire_state.last_family_discrepancy = 0;
+  onewire_state.last_device_flag = false;
+
+  return false;
+}
+
+onewire_search_pass_result_t perform_search_pass(void) {
   bool id_bit;
   bool cmp_id_bit;
 
   uint8_t id_bit_number;
   uint8_t last_zero;
   uint8_t rom_byte_offset;
-  uint8_t search_result;
   uint8_t rom_byte_mask;
   uint8_t search_direction;
 
@@ -1049,140 +1402,195 @@ bool perform_device_search(void) {
   last_zero = 0;
   rom_byte_offset = 0;
   rom_byte_mask = 1;
-  search_result = 0;
   onewire_state.crc8 = 0;
 
-  /* Check if the bus enumeration is still in progress. */
+  if (perform_bus_reset()) {
+    return ONEWIRE_SEARCH_PASS_NO_DEVICE;
+  }
 
-  if (!onewire_state.last_device_flag) {
+  /* Issue search command. */
 
-    /* The last device on the bus was not yet found. */
+  ONEWIRE_WRITE_BYTE(onewire_state.command_byte);
 
-    if (perform_bus_reset()) {
-      onewire_state.last_device_discrepancy = 0;
-      onewire_state.last_family_discrepancy = 0;
-      onewire_state.last_device_flag = false;
+  do {
 
-      return false;
+    /* Read a bit and its complement. */
+
+    id_bit = ONEWIRE_READ_BIT();
+    cmp_id_bit = ONEWIRE_READ_BIT();
+
+    if ((id_bit == ON) && (cmp_id_bit == ON)) {
+
+      /*
+       * Nobody answered: either there are no devices on the line, or the
+       * device being followed dropped out halfway through the pass.
+       */
+
+      return (id_bit_number == 1) ? ONEWIRE_SEARCH_PASS_NO_DEVICE
+                                  : ONEWIRE_SEARCH_PASS_CORRUPTED;
     }
 
-    /* Issue search command. */
+    if (id_bit != cmp_id_bit) {
+      search_direction = id_bit;
+    } else {
 
-    ONEWIRE_WRITE_BYTE(onewire_state.command_byte);
+      /*
+       * Determine the search direction from the last recorded discrepancy
+       * index.
+       */
 
-    do {
+      if (id_bit_number < onewire_state.last_device_discrepancy) {
+        search_direction =
+            (onewire_state.rom_bytes[rom_byte_offset] & rom_byte_mask) > 0;
+      } else {
 
-      /* Read a bit and its complement. */
+        /* Determine search direction. */
 
-      id_bit = ONEWIRE_READ_BIT();
-      cmp_id_bit = ONEWIRE_READ_BIT();
+        search_direction =
+            (id_bit_number == onewire_state.last_device_discrepancy);
+      }
 
-      if ((id_bit == ON) && (cmp_id_bit == ON)) {
+      /* If a 0 was read, then record its position. */
 
-        /* No devices on the line, bail out. */
+      if (search_direction == 0) {
+        last_zero = id_bit_number;
 
-        break;
+        /* Check for the last bit discrepancy in the family byte. */
+
+        if (last_zero < 9) {
+          onewire_state.last_family_discrepancy = last_zero;
+        }
       }
+    }
 
-      if (id_bit != cmp_id_bit) {
-        search_direction = id_bit;
-      } else {
+    /*
+     * Set or clear the current ROM address bit according to the search
+     * direction.
+     */
+    if (search_direction == 1) {
+      onewire_state.rom_bytes[rom_byte_offset] |= rom_byte_mask;
+    } else {
+      onewire_state.rom_bytes[rom_byte_offset] &= ~rom_byte_mask;
+    }
 
-        /*
-         * Determine the search direction from the last recorded discrepancy
-         * index.
-         */
+    /* Write the serial number search direction bit. */
 
-        if (id_bit_number < onewire_state.last_device_discrepancy) {
-          search_direction =
-              (onewire_state.rom_bytes[rom_byte_offset] & rom_byte_mask) > 0;
-        } else {
+    ONEWIRE_WRITE_BIT(search_direction);
 
-          /* Determine search direction. */
+    /* Advance by one bit. */
 
-          search_direction =
-              (id_bit_number == onewire_state.last_device_discrepancy);
-        }
+    id_bit_number++;
+    rom_byte_mask <<= 1;
 
-        /* If a 0 was read, then record its position. */
+    /* If 8 bits have been read, update CRC and move to the next byte. */
 
-        if (search_direction == 0) {
-          last_zero = id_bit_number;
+    if (rom_byte_mask == 0) {
 
-          /* Check for the last bit discrepancy in the family byte. */
+      /* Calculate CRC. */
 
-          if (last_zero < 9) {
-            onewire_state.last_family_discrepancy = last_zero;
-          }
-        }
-      }
+      update_crc8(onewire_state.rom_bytes[rom_byte_offset]);
+      rom_byte_offset++;
+      rom_byte_mask = 1;
+    }
 
-      /*
-       * Set or clear the current ROM address bit according to the search
-       * direction.
-       */
-      if (search_direction == 1) {
-        onewire_state.rom_bytes[rom_byte_offset] |= rom_byte_mask;
-      } else {
-        onewire_state.rom_bytes[rom_byte_offset] &= ~rom_byte_mask;
-      }
+    /* Get all 8 bytes. */
 
-      /* Write the serial number search direction bit. */
+  } while (rom_byte_offset < ROM_BYTES_SIZE);
 
-      ONEWIRE_WRITE_BIT(search_direction);
+  /* Checks the result of the search. */
 
-      /* Advance by one bit. */
+  if ((onewire_state.crc8 != 0) || !onewire_state.rom_bytes[0]) {
+    return ONEWIRE_SEARCH_PASS_CORRUPTED;
+  }
 
-      id_bit_number++;
-      rom_byte_mask <<= 1;
+  /* Update search state values. */
 
-      /* If 8 bits have been read, update CRC and move to the next byte. */
+  onewire_state.last_device_discrepancy = last_zero;
 
-      if (rom_byte_mask == 0) {
+  if (onewire_state.last_device_discrepancy == 0) {
+    onewire_state.last_device_flag = true;
+  }
 
-        /* Calculate CRC. */
+  /* Found a device. */
 
-        update_crc8(onewire_state.rom_bytes[rom_byte_offset]);
-        rom_byte_offset++;
-        rom_byte_mask = 1;
-      }
+  return ONEWIRE_SEARCH_PASS_FOUND;
+}
 
-      /* Get all 8 bytes. */
+bool is_roster_thermometer(const uint8_t family) {
+  return (family == DS18S20) || (family == DS1822) || (family == DS18B20);
+}
 
-    } while (rom_byte_offset < ROM_BYTES_SIZE);
+bool roster_start_conversion(void) {
+  bool parasitic_power;
+  uint16_t elapsed;
 
-    /* Checks the result of the search. */
+  /* Check whether any device on the bus relies on parasitic power. */
 
-    if (!((id_bit_number < 65) || (onewire_state.crc8 != 0))) {
+  if (perform_bus_reset() != ONEWIRE_BUS_RESET_OK) {
+    return false;
+  }
+  ONEWIRE_WRITE_BYTE(MACRO_SKIP_ROM);
+  ONEWIRE_WRITE_BYTE(DS18X20_READ_POWER_SUPPLY);
+  parasitic_power = !ONEWIRE_READ_BIT();
 
-      /* Update search state values. */
+  /* Start the conversion on all devices at once. */
 
-      onewire_state.last_device_discrepancy = last_zero;
+  if (perform_bus_reset() != ONEWIRE_BUS_RESET_OK) {
+    return false;
+  }
+  ONEWIRE_WRITE_BYTE(MACRO_SKIP_ROM);
+  ONEWIRE_WRITE_BYTE(DS18X20_CONVERT_T);
 
-      if (onewire_state.last_device_discrepancy == 0) {
-        onewire_state.last_device_flag = true;
-      }
+  if (parasitic_power) {
+
+    /*
+     * Parasitically powered devices cannot signal the end of the conversion,
+     * so leave the line to the pull-up for the worst case conversion time.
+     */
+
+    bp_delay_ms(TEMPERATURE_CONVERSION_TIMEOUT_MS);
+    return true;
+  }
 
-      /* Found a device. */
+  /* Devices hold the line low on read slots until the conversion is done. */
 
-      search_result = true;
+  for (elapsed = 0; elapsed < TEMPERATURE_CONVERSION_TIMEOUT_MS; elapsed++) {
+    if (ONEWIRE_READ_BIT()) {
+      break;
     }
+    bp_delay_ms(1);
   }
 
-  /* No device was found, so reset search state to a clean slate. */
+  return true;
+}
+
+bool roster_read_scratchpad(const uint8_t *rom_address, uint8_t *scratchpad) {
+  size_t index;
+
+  if (perform_bus_reset() != ONEWIRE_BUS_RESET_OK) {
+    memset(scratchpad, 0xFF, SCRATCHPAD_BYTES_SIZE);
+    return false;
+  }
+
+  ONEWIRE_WRITE_BYTE(MACRO_MATCH_ROM);
+  for (index = 0; index < ROM_BYTES_SIZE; index++) {
+    ONEWIRE_WRITE_BYTE(rom_address[index]);
+  }
+  ONEWIRE_WRITE_BYTE(DS18X20_READ_SCRATCHPAD);
+
+  /* The CRC of the whole scratchpad including its CRC byte must be zero. */
 
-  if (!search_result || !onewire_state.rom_bytes[0]) {
-    onewire_state.last_device_discrepancy = 0;
-    onewire_state.last_family_discrepancy = 0;
-    onewire_state.last_device_flag = false;
-    search_result = false;
+  onewire_state.crc8 = 0;
+  for (index = 0; index < SCRATCHPAD_BYTES_SIZE; index++) {
+    scratchpad[index] = ONEWIRE_READ_BYTE();
+    update_crc8(scratchpad[index]);
   }
 
-  return search_result;
+  return onewire_state.crc8 == 0;
 }
 
 uint8_t update_crc8(const uint8_t value) {
-  onewire_state.crc8 = CRC_TABLE[onewire_state.crc8 ^ value];
+  onewire_state.crc8 = crc8_maxim_update(onewire_state.crc8, value);
   return onewire_state.crc8;
 }
 
@@ -1202,6 +1610,10 @@ void binary_io_enter_1wire_mode(void) {
 
   mode_configuration.little_endian = NO;
 
+  /* Start at standard speed. */
+
+  onewire_set_speed(0);
+
   /* Send version string. */
 
   MSG_1WIRE_MODE_IDENTIFIER;
@@ -1241,13 +1653,21 @@ void binary_io_enter_1wire_mode(void) {
                 ? MACRO_ALARM_SEARCH
                 : MACRO_SEARCH_ROM;
 
-        /* Find all devices. */
+        /* Find all devices, saving them in the roster if possible. */
 
+        onewire_state.used_roster_entries = 0;
         next = device_find_first();
         while (next) {
           /* Print address. */
           bp_write_buffer(&onewire_state.rom_bytes[0],
                           sizeof(onewire_state.rom_bytes));
+          if (onewire_state.used_roster_entries <
+              BP_1WIRE_DEVICE_DEV_ROSTER_SLOTS) {
+            memcpy(
+                onewire_state.roster_entries[onewire_state.used_roster_entries],
+                onewire_state.rom_bytes, sizeof(onewire_state.rom_bytes));
+            onewire_state.used_roster_entries++;
+          }
           next = device_find_next();
         }
 
@@ -1260,6 +1680,56 @@ void binary_io_enter_1wire_mode(void) {
         break;
       }
 
+      case BINARY_IO_ONEWIRE_ACTION_OVERDRIVE_SKIP_ROM:
+        if (onewire_enter_overdrive(MACRO_OVERDRIVE_SKIP_ROM) ==
+            ONEWIRE_BUS_RESET_OK) {
+          REPORT_IO_SUCCESS();
+        } else {
+          REPORT_IO_FAILURE();
+        }
+        break;
+
+      case BINARY_IO_ONEWIRE_ACTION_ROSTER_CONVERT_READ: {
+        uint8_t scratchpad[SCRATCHPAD_BYTES_SIZE];
+        uint8_t records;
+        size_t index;
+
+        records = 0;
+        for (index = 0; index < onewire_state.used_roster_entries; index++) {
+          if (is_roster_thermometer(onewire_state.roster_entries[index][0])) {
+            records++;
+          }
+        }
+
+        if ((records == 0) || !roster_start_conversion()) {
+          REPORT_IO_FAILURE();
+          break;
+        }
+
+        REPORT_IO_SUCCESS();
+        user_serial_transmit_character(records);
+
+        for (index = 0; index < onewire_state.used_roster_entries; index++) {
+          bool valid;
+
+          if (!is_roster_thermometer(onewire_state.roster_entries[index][0])) {
+            continue;
+          }
+
+          valid = roster_read_scratchpad(onewire_state.roster_entries[index],
+                                         scratchpad);
+          bp_write_buffer(onewire_state.roster_entries[index], ROM_BYTES_SIZE);
+          bp_write_buffer(scratchpad, sizeof(scratchpad));
+          if (valid) {
+            REPORT_IO_SUCCESS();
+          } else {
+            REPORT_IO_FAILURE();
+          }
+        }
+
+        break;
+      }
+
       default:
         REPORT_IO_FAILURE();
         break;
@@ -1281,7 +1751,7 @@ void binary_io_enter_1wire_mode(void) {
     }
 
     case BINARY_IO_ONEWIRE_COMMAND_CONFIGURE:
-      mode_configuration.speed = (input_byte & 1);
+      onewire_set_speed(input_byte & 1);
       user_serial_transmit_character(BP_BINARY_IO_RESULT_SUCCESS);
       break;
 
@@ -1309,18 +1779,12 @@ bool onewire_internal_bit_io(bool bit_value) {
   ONEWIRE_DATA_DIRECTION = OUTPUT;
 
   /* AN126: Parameter A */
-  if (mode_configuration.speed == 0) {
-    bp_delay_us(4);
-  } else {
-    bp_delay_us(1);
-  }
+  onewire_delay_cycles(onewire_timings->slot_start);
   if (bit_value) {
     ONEWIRE_DATA_DIRECTION = INPUT;
   }
   /* AN126: Parameter E */
-  if (mode_configuration.speed == 0) {
-    bp_delay_us(8);
-  }
+  onewire_delay_cycles(onewire_timings->read_sample);
 
   /*
    * This is where the magic happens. If a bit_value value of 1 is sent to this
@@ -1334,32 +1798,18 @@ bool onewire_internal_bit_io(bool bit_value) {
   if (bit_value) {
     bit_value = ONEWIRE_DATA_LINE;
     /* AN126: Parameter F */
-    if (mode_configuration.speed == 0) {
-      bp_delay_us(32);
-    } else {
-      bp_delay_us(6);
-    }
+    onewire_delay_cycles(onewire_timings->read_recovery);
   } else {
     /* AN126: Parameter C */
-    if (mode_configuration.speed == 0) {
-      bp_delay_us(25);
-    } else {
-      bp_delay_us(4);
-    }
+    onewire_delay_cycles(onewire_timings->write_zero_low);
     ONEWIRE_DATA_DIRECTION = INPUT;
     /* AN126: Parameter D */
-    if (mode_configuration.speed == 0) {
-      bp_delay_us(7);
-    } else {
-      bp_delay_us(2);
-    }
+    onewire_delay_cycles(onewire_timings->write_zero_recovery);
   }
 
   /* Adjust timing to take 70us per bit for standard mode. */
 
-  if (mode_configuration.speed == 0) {
-    bp_delay_us(5);
-  }
+  onewire_delay_cycles(onewire_timings->slot_padding);
 
   return bit_value;
 }
@@ -1387,13 +1837,44 @@ uint8_t onewire_internal_byte_io(uint8_t byte_value) {
     }
   }
 
-  if (mode_configuration.speed == 0) {
-    bp_delay_us(8);
-  }
+  onewire_delay_cycles(onewire_timings->byte_padding);
 
   return byte_value;
 }
 
+void onewire_delay_cycles(const uint16_t cycles) {
+  if (cycles > 0) {
+    __delay32(cycles);
+  }
+}
+
+void onewire_set_speed(const uint8_t speed) {
+  mode_configuration.speed = (speed > 0) ? 1 : 0;
+  onewire_timings = &ONEWIRE_TIMINGS[mode_configuration.speed];
+}
+
+onewire_bus_reset_result_t onewire_enter_overdrive(const uint8_t command) {
+  onewire_bus_reset_result_t result;
+
+  /* Devices only accept overdrive commands after a standard speed reset. */
+
+  onewire_set_speed(0);
+  result = perform_bus_reset();
+  if (result != ONEWIRE_BUS_RESET_OK) {
+    return result;
+  }
+
+  /*
+   * The command byte itself goes out at standard speed, everything after it
+   * (including the ROM address for Overdrive Match ROM) at overdrive speed.
+   */
+
+  ONEWIRE_WRITE_BYTE(command);
+  onewire_set_speed(1);
+
+  return result;
+}
+
 void onewire_internal_set_data_state(const bool state) {
   onewire_state.data_state = state;
   MSG_1WIRE_NEXT_CLOCK_ALERT;
@@ -33,6 +33,51 @@
 extern mode_configuration_t mode_configuration;
 extern bool command_error;
 
+/**
+ * @brief Gate length for the classic frequency counter, in instruction cycles.
+ */
+#define FREQUENCY_COUNTER_ONE_SECOND_GATE FCY
+
+/**
+ * @brief Gate length for the reciprocal frequency counter probe pass.
+ *
+ * The probe pass counts edges for 10ms to pick the capture strategy.
+ */
+#define RECIPROCAL_PROBE_GATE (FCY / 100)
+
+/**
+ * @brief Minimum gate length for the reciprocal frequency counter.
+ *
+ * The gate is closed on the first captured edge after this many instruction
+ * cycles have elapsed since the edge that opened it.
+ */
+#define RECIPROCAL_MINIMUM_GATE (FCY / 10)
+
+/**
+ * @brief How long to wait for the next edge before giving up, in cycles.
+ *
+ * Slightly longer than a second, so 1Hz signals can still be measured.
+ */
+#define RECIPROCAL_EDGE_TIMEOUT (FCY + (FCY / 4))
+
+/**
+ * @brief Frequency above which edges are captured in groups of 16, in Hz.
+ */
+#define RECIPROCAL_PRESCALED_CAPTURE_FREQUENCY 50000
+
+/**
+ * @brief Frequency above which a plain gated count is used instead, in Hz.
+ *
+ * At this rate a 100ms gated count with a 1:8 prescaler already has a
+ * resolution of 20ppm or better.
+ */
+#define RECIPROCAL_GATED_COUNT_FREQUENCY 4000000
+
+/**
+ * @brief Timer #2 prescaler used for the gated counts of the reciprocal mode.
+ */
+#define RECIPROCAL_COUNTER_PRESCALER 8
+
 /**
  * @brief Possible modes for the AUX pins.
  */
@@ -46,12 +91,13 @@ typedef enum {
 } __attribute__((packed)) aux_mode_t;
 
 /**
- * @brief Reads the AUX signal for one second, returning the detected frequency.
+ * @brief Counts the AUX signal edges seen by timer #2 within the given gate.
  *
- * @return the detected frequency on the AUX pin in the second spent sampling,
- * in Hz.
+ * @param[in] gate the gate length, in instruction cycles.
+ *
+ * @return the number of timer #2 increments counted while the gate was open.
  */
-static uint32_t poll_frequency_counter_value(void);
+static uint32_t poll_frequency_counter_value(const uint32_t gate);
 
 /**
  * @brief Gets the average frequency for the given samples count.
@@ -62,6 +108,47 @@ static uint32_t poll_frequency_counter_value(void);
  */
 static uint32_t average_sample_frequency(const uint16_t count);
 
+/**
+ * @brief Starts the input capture units timestamping the AUX pin edges.
+ *
+ * IC1 captures the low word and IC2 the high word of a free-running 32 bits
+ * timer clocked at FCY, on the edges selected by the given capture mode.
+ *
+ * @param[in] mode the ICM value to use for both capture units.
+ */
+static void start_input_capture(const uint16_t mode);
+
+/**
+ * @brief Stops the input capture units and their timebase.
+ */
+static void stop_input_capture(void);
+
+/**
+ * @brief Starts IC3/IC4 timestamping the AUX pin falling edges.
+ *
+ * The units share the timebase started by start_input_capture(), with IC3
+ * capturing the low word and IC4 the high word.
+ */
+static void start_falling_edge_capture(void);
+
+/**
+ * @brief Stops the IC3/IC4 falling edge capture units.
+ */
+static void stop_falling_edge_capture(void);
+
+/**
+ * @brief Runs one reciprocal counting pass with the given capture mode.
+ *
+ * @param[in]  mode              the ICM value to capture edges with.
+ * @param[in]  edges_per_capture how many rising edges each capture stands for.
+ * @param[out] measurement       where to store the counted edges and cycles.
+ *
+ * @return true if the pass completed, false if the capture buffer overflowed.
+ */
+static bool reciprocal_counting_pass(const uint16_t mode,
+                                     const uint16_t edges_per_capture,
+                                     bp_frequency_measurement_t *measurement);
+
 /**
  * @brief Stops the two timers used in the PWM/frequency counting process.
  */
@@ -84,6 +171,16 @@ typedef struct {
  */
 static aux_state_t state = {0};
 
+/**
+ * @brief Timestamp of the rising edge closing the last pulse train window.
+ */
+static uint32_t pulse_train_last_rising_edge;
+
+/**
+ * @brief Whether pulse_train_last_rising_edge can open the next window.
+ */
+static bool pulse_train_synchronised;
+
 /**
  * @brief Sets up input clock prescaler and returns an appropriate divisor.
  *
@@ -410,7 +507,7 @@ void bp_frequency_counter_setup(void) {
           (ON << _T2CON_TCKPS0_POSITION) | (ON << _T2CON_TCKPS1_POSITION);
 
   /* Can measure up to 67MHz (26 bits). */
-  frequency = poll_frequency_counter_value();
+  frequency = poll_frequency_counter_value(FREQUENCY_COUNTER_ONE_SECOND_GATE);
 
   if (frequency > 0x3FFF) {
     /* Adjust for prescaler. */
@@ -420,7 +517,7 @@ void bp_frequency_counter_setup(void) {
     BPMSG1245;
     T2CONbits.TCKPS0 = OFF;
     T2CONbits.TCKPS1 = OFF;
-    frequency = poll_frequency_counter_value();
+    frequency = poll_frequency_counter_value(FREQUENCY_COUNTER_ONE_SECOND_GATE);
   }
 
   if (frequency > 3999) {
@@ -539,7 +636,7 @@ uint32_t bp_measure_frequency(void) {
   T2CON = (ON << _T2CON_TCS_POSITION) | (ON << _T2CON_T32_POSITION) |
           (ON << _T2CON_TCKPS0_POSITION) | (ON << _T2CON_TCKPS1_POSITION);
 
-  frequency = poll_frequency_counter_value();
+  frequency = poll_frequency_counter_value(FREQUENCY_COUNTER_ONE_SECOND_GATE);
   if (frequency > 0xFF) {
     /* Adjust for prescaler. */
     frequency *= 256;
@@ -547,7 +644,7 @@ uint32_t bp_measure_frequency(void) {
     /* Use a less aggressive prescaler, set to 1:1. */
     T2CONbits.TCKPS0 = OFF;
     T2CONbits.TCKPS1 = OFF;
-    frequency = poll_frequency_counter_value();
+    frequency = poll_frequency_counter_value(FREQUENCY_COUNTER_ONE_SECOND_GATE);
   }
 
   /* Remove clock input pin assignment. */
@@ -558,7 +655,7 @@ uint32_t bp_measure_frequency(void) {
   return frequency;
 }
 
-uint32_t poll_frequency_counter_value(void) {
+uint32_t poll_frequency_counter_value(const uint32_t gate) {
   uint32_t counter_low;
   uint32_t counter_high;
 
@@ -577,9 +674,9 @@ uint32_t poll_frequency_counter_value(void) {
   /* Set timer #4 as 32 bits. */
   T4CONbits.T32 = YES;
 
-  /* Set 32-bits period register for timer #4 (0x00F42400, one second). */
-  PR5 = 0x00F4;
-  PR4 = 0x2400;
+  /* Set 32-bits period register for timer #4. */
+  PR5 = (uint16_t)(gate >> 16);
+  PR4 = (uint16_t)(gate & 0xFFFF);
 
   /* Clear timer #4 interrupt flag (32 bits mode). */
   IFS1bits.T5IF = OFF;
@@ -608,15 +705,114 @@ uint32_t poll_frequency_counter_value(void) {
 #if defined(BUSPIRATEV4)
 #define IC1ICBNE IC1CON1bits.ICBNE
 #define IC2ICBNE IC2CON1bits.ICBNE
+#define IC1ICOV IC1CON1bits.ICOV
+#define IC3ICBNE IC3CON1bits.ICBNE
+#define IC3ICOV IC3CON1bits.ICOV
+#define CAPTURE_TIMER_LOW TMR4
+#define CAPTURE_TIMER_HIGH TMR5HLD
 #else
 #define IC1ICBNE IC1CONbits.ICBNE
 #define IC2ICBNE IC2CONbits.ICBNE
+#define IC1ICOV IC1CONbits.ICOV
+#define IC3ICBNE IC3CONbits.ICBNE
+#define IC3ICOV IC3CONbits.ICOV
+#define CAPTURE_TIMER_LOW TMR2
+#define CAPTURE_TIMER_HIGH TMR3HLD
 #endif /* BUSPIRATEV4 */
 
+/**
+ * @brief Reads the current value of the 32 bits input capture timebase.
+ *
+ * @return the input capture timebase value, in instruction cycles.
+ */
+static inline uint32_t capture_timer_value(void) {
+  uint16_t low_word;
+
+  low_word = CAPTURE_TIMER_LOW;
+  return ((uint32_t)CAPTURE_TIMER_HIGH << 16) | low_word;
+}
+
+/**
+ * @brief Pops the oldest rising edge timestamp captured by IC1/IC2.
+ *
+ * @return the rising edge timestamp, in instruction cycles.
+ */
+static inline uint32_t pop_rising_edge(void) {
+  uint16_t low_word;
+
+  low_word = IC1BUF;
+  return ((uint32_t)IC2BUF << 16) | low_word;
+}
+
+/**
+ * @brief Pops the oldest falling edge timestamp captured by IC3/IC4.
+ *
+ * @return the falling edge timestamp, in instruction cycles.
+ */
+static inline uint32_t pop_falling_edge(void) {
+  uint16_t low_word;
+
+  low_word = IC3BUF;
+  return ((uint32_t)IC4BUF << 16) | low_word;
+}
+
+/**
+ * @brief Input capture mode timestamping every rising edge.
+ */
+#define INPUT_CAPTURE_EVERY_RISING_EDGE 0b011
+
+/**
+ * @brief Input capture mode timestamping every falling edge.
+ */
+#define INPUT_CAPTURE_EVERY_FALLING_EDGE 0b010
+
+/**
+ * @brief Input capture mode timestamping every 16th rising edge.
+ */
+#define INPUT_CAPTURE_EVERY_16TH_RISING_EDGE 0b101
+
 uint32_t average_sample_frequency(const uint16_t count) {
   uint32_t current_low, counter_low, current_high, counter_high, total_samples;
   uint16_t index;
 
+  start_input_capture(INPUT_CAPTURE_EVERY_RISING_EDGE);
+
+  /* Flush IC1. */
+  while (IC1ICBNE == ON) {
+    current_low = IC1BUF;
+  }
+
+  /* Flush IC2. */
+  while (IC2ICBNE == ON) {
+    counter_low = IC2BUF;
+  }
+
+  while (IC1ICBNE == OFF) {
+  }
+
+  counter_low = IC1BUF;
+  counter_high = IC2BUF;
+  total_samples = 0;
+
+  for (index = 0; index < count; index++) {
+    /* Wait for signal. */
+    while (IC1ICBNE == OFF) {
+    }
+
+    current_low = IC1BUF;
+    current_high = IC2BUF;
+    total_samples +=
+        ((current_high - counter_high) << 16) + (current_low - counter_low);
+    counter_high = current_high;
+    counter_low = current_low;
+  }
+
+  stop_input_capture();
+
+  return total_samples / count;
+}
+
+void start_input_capture(const uint16_t mode) {
   /* Clear input capture interrupts. */
   IFS0bits.IC2IF = OFF;
   IFS0bits.IC1IF = OFF;
@@ -653,14 +849,14 @@ uint32_t average_sample_frequency(const uint16_t count) {
    * IC2CON1
    *
    * MSB
-   * --0011---00--011
+   * --0011---00--xxx
    *   ||||   ||  |||
-   *   ||||   ||  +++-- ICM:    Simple capture mode, on every rising edge.
+   *   ||||   ||  +++-- ICM:    Capture mode as requested by the caller.
    *   ||||   ++------- ICI:    Interrupt on every capture event.
    *   |+++------------ ICTSEL: Use input capture timer 5.
    *   +--------------- ICSIDL: Input capture continues on CPU idle mode.
    */
-  IC2CON1 = (0b011 << _IC2CON1_ICM_POSITION) | (0b00 << _IC2CON1_ICI_POSITION) |
+  IC2CON1 = (mode << _IC2CON1_ICM_POSITION) | (0b00 << _IC2CON1_ICI_POSITION) |
             (0b011 << _IC2CON1_ICTSEL_POSITION) |
             (OFF << _IC2CON1_ICSIDL_POSITION);
 
@@ -684,14 +880,14 @@ uint32_t average_sample_frequency(const uint16_t count) {
   /*
    * IC1CON1
    *
-   * --0010---00--011
+   * --0010---00--xxx
    *   ||||   ||  |||
-   *   ||||   ||  +++-- ICM:    Simple capture mode, on every rising edge.
+   *   ||||   ||  +++-- ICM:    Capture mode as requested by the caller.
    *   ||||   ++------- ICI:    Interrupt on every capture event.
    *   |+++------------ ICTSEL: Use input capture timer 4.
    *   +--------------- ICSIDL: Input capture continues on CPU idle mode.
    */
-  IC1CON1 = (0b011 << _IC1CON1_ICM_POSITION) | (0b00 << _IC1CON1_ICI_POSITION) |
+  IC1CON1 = (mode << _IC1CON1_ICM_POSITION) | (0b00 << _IC1CON1_ICI_POSITION) |
             (0b010 << _IC1CON1_ICTSEL_POSITION) |
             (OFF << _IC1CON1_ICSIDL_POSITION);
 
@@ -738,14 +934,14 @@ uint32_t average_sample_frequency(const uint16_t count) {
    * IC2CON
    *
    * MSB
-   * --0-----000--011
+   * --0-----000--xxx
    *   |     |||  |||
-   *   |     |||  +++-- ICM:    Capture every rising edge.
+   *   |     |||  +++-- ICM:    Capture mode as requested by the caller.
    *   |     |++------- ICI:    Interrupt on every capture event.
    *   |     +--------- ICTMR:  TMR3 contents are captured on event.
    *   +--------------- ICSIDL: Input capture continues on CPU idle.
    */
-  IC2CON = (0b011 << _IC2CON_ICM_POSITION) | (0b00 << _IC2CON_ICI_POSITION) |
+  IC2CON = (mode << _IC2CON_ICM_POSITION) | (0b00 << _IC2CON_ICI_POSITION) |
            (OFF << _IC2CON_ICTMR_POSITION) | (OFF << _IC2CON_ICSIDL_POSITION);
 
   /* Setup Input Capture 1. */
@@ -754,48 +950,20 @@ uint32_t average_sample_frequency(const uint16_t count) {
    * IC1CON
    *
    * MSB
-   * --0-----100--011
+   * --0-----100--xxx
    *   |     |||  |||
-   *   |     |||  +++-- ICM:    Capture every rising edge.
+   *   |     |||  +++-- ICM:    Capture mode as requested by the caller.
    *   |     |++------- ICI:    Interrupt on every capture event.
    *   |     +--------- ICTMR:  TMR2 contents are captured on event.
    *   +--------------- ICSIDL: Input capture continues on CPU idle.
    */
-  IC1CON = (0b011 << _IC2CON_ICM_POSITION) | (0b00 << _IC2CON_ICI_POSITION) |
+  IC1CON = (mode << _IC2CON_ICM_POSITION) | (0b00 << _IC2CON_ICI_POSITION) |
            (ON << _IC2CON_ICTMR_POSITION) | (OFF << _IC2CON_ICSIDL_POSITION);
 
 #endif /* BUSPIRATEV4 */
+}
 
-  /* Flush IC1. */
-  while (IC1ICBNE == ON) {
-    current_low = IC1BUF;
-  }
-
-  /* Flush IC2. */
-  while (IC2ICBNE == ON) {
-    counter_low = IC2BUF;
-  }
-
-  while (IC1ICBNE == OFF) {
-  }
-
-  counter_low = IC1BUF;
-  counter_high = IC2BUF;
-  total_samples = 0;
-
-  for (index = 0; index < count; index++) {
-    /* Wait for signal. */
-    while (IC1ICBNE == OFF) {
-    }
-
-    current_low = IC1BUF;
-    current_high = IC2BUF;
-    total_samples +=
-        ((current_high - counter_high) << 16) + (current_low - counter_low);
-    counter_high = current_high;
-    counter_low = current_low;
-  }
-
+void stop_input_capture(void) {
 #if defined(BUSPIRATEV4)
 
   /* Stop input capture units. */
@@ -863,8 +1031,340 @@ uint32_t average_sample_frequency(const uint16_t count) {
   T2CONbits.TON = OFF;
 
 #endif /* BUSPIRATEV4 */
+}
 
-  return total_samples / count;
+void start_falling_edge_capture(void) {
+  /* Clear input capture interrupts. */
+  IFS2bits.IC3IF = OFF;
+  IFS2bits.IC4IF = OFF;
+
+  /* Assign input capture pin. */
+  RPINR8bits.IC3R = AUXPIN_RPIN;
+  RPINR8bits.IC4R = AUXPIN_RPIN;
+
+#if defined(BUSPIRATEV4)
+
+  /*
+   * IC4CON1
+   *
+   * MSB
+   * --0011---00--010
+   *   ||||   ||  |||
+   *   ||||   ||  +++-- ICM:    Simple capture mode, on every falling edge.
+   *   ||||   ++------- ICI:    Interrupt on every capture event.
+   *   |+++------------ ICTSEL: Use input capture timer 5.
+   *   +--------------- ICSIDL: Input capture continues on CPU idle mode.
+   */
+  IC4CON1 = (INPUT_CAPTURE_EVERY_FALLING_EDGE << _IC4CON1_ICM_POSITION) |
+            (0b00 << _IC4CON1_ICI_POSITION) |
+            (0b011 << _IC4CON1_ICTSEL_POSITION) |
+            (OFF << _IC4CON1_ICSIDL_POSITION);
+  IC4CON2 = (0b10100 << _IC4CON2_SYNCSEL_POSITION);
+
+  /*
+   * IC3CON1
+   *
+   * MSB
+   * --0010---00--010
+   *   ||||   ||  |||
+   *   ||||   ||  +++-- ICM:    Simple capture mode, on every falling edge.
+   *   ||||   ++------- ICI:    Interrupt on every capture event.
+   *   |+++------------ ICTSEL: Use input capture timer 4.
+   *   +--------------- ICSIDL: Input capture continues on CPU idle mode.
+   */
+  IC3CON1 = (INPUT_CAPTURE_EVERY_FALLING_EDGE << _IC3CON1_ICM_POSITION) |
+            (0b00 << _IC3CON1_ICI_POSITION) |
+            (0b010 << _IC3CON1_ICTSEL_POSITION) |
+            (OFF << _IC3CON1_ICSIDL_POSITION);
+  IC3CON2 = (0b10100 << _IC3CON2_SYNCSEL_POSITION);
+
+#else
+
+  /*
+   * IC4CON
+   *
+   * MSB
+   * --0-----000--010
+   *   |     |||  |||
+   *   |     |||  +++-- ICM:    Capture every falling edge.
+   *   |     |++------- ICI:    Interrupt on every capture event.
+   *   |     +--------- ICTMR:  TMR3 contents are captured on event.
+   *   +--------------- ICSIDL: Input capture continues on CPU idle.
+   */
+  IC4CON = (INPUT_CAPTURE_EVERY_FALLING_EDGE << _IC4CON_ICM_POSITION) |
+           (0b00 << _IC4CON_ICI_POSITION) | (OFF << _IC4CON_ICTMR_POSITION) |
+           (OFF << _IC4CON_ICSIDL_POSITION);
+
+  /*
+   * IC3CON
+   *
+   * MSB
+   * --0-----100--010
+   *   |     |||  |||
+   *   |     |||  +++-- ICM:    Capture every falling edge.
+   *   |     |++------- ICI:    Interrupt on every capture event.
+   *   |     +--------- ICTMR:  TMR2 contents are captured on event.
+   *   +--------------- ICSIDL: Input capture continues on CPU idle.
+   */
+  IC3CON = (INPUT_CAPTURE_EVERY_FALLING_EDGE << _IC3CON_ICM_POSITION) |
+           (0b00 << _IC3CON_ICI_POSITION) | (ON << _IC3CON_ICTMR_POSITION) |
+           (OFF << _IC3CON_ICSIDL_POSITION);
+
+#endif /* BUSPIRATEV4 */
+}
+
+void stop_falling_edge_capture(void) {
+#if defined(BUSPIRATEV4)
+  IC3CON1 = 0x0000;
+  IC4CON1 = 0x0000;
+#else
+  IC3CON = 0x0000;
+  IC4CON = 0x0000;
+#endif /* BUSPIRATEV4 */
+}
+
+bool reciprocal_counting_pass(const uint16_t mode,
+                              const uint16_t edges_per_capture,
+                              bp_frequency_measurement_t *measurement) {
+  uint32_t first_edge;
+  uint32_t last_edge;
+
+  measurement->edges = 0;
+  measurement->cycles = 0;
+
+  start_input_capture(mode);
+
+  /* Flush IC1. */
+  while (IC1ICBNE == ON) {
+    IC1BUF;
+  }
+
+  /* Flush IC2. */
+  while (IC2ICBNE == ON) {
+    IC2BUF;
+  }
+
+  /* Wait for the edge opening the gate. */
+  last_edge = capture_timer_value();
+  while (IC1ICBNE == OFF) {
+    if ((capture_timer_value() - last_edge) > RECIPROCAL_EDGE_TIMEOUT) {
+      stop_input_capture();
+      return true;
+    }
+  }
+
+  first_edge = pop_rising_edge();
+  last_edge = first_edge;
+
+  for (;;) {
+    if (IC1ICOV == ON) {
+      /* Edges come in faster than they can be read back. */
+      stop_input_capture();
+      return false;
+    }
+
+    if (IC1ICBNE == ON) {
+      last_edge = pop_rising_edge();
+      measurement->edges += edges_per_capture;
+      if ((last_edge - first_edge) >= RECIPROCAL_MINIMUM_GATE) {
+        break;
+      }
+      continue;
+    }
+
+    /* The signal stopped, keep whatever was counted so far. */
+    if ((capture_timer_value() - last_edge) > RECIPROCAL_EDGE_TIMEOUT) {
+      break;
+    }
+  }
+
+  stop_input_capture();
+  measurement->cycles = last_edge - first_edge;
+
+  return true;
+}
+
+void bp_measure_frequency_reciprocal(bp_frequency_measurement_t *measurement) {
+  uint32_t estimate;
+
+  stop_timers();
+  AUXPIN_DIR = INPUT;
+
+  /* Run a short gated count on timer 2 to pick a capture strategy. */
+  RPINR3bits.T2CKR = AUXPIN_RPIN;
+
+  /*
+   * T2CON
+   *
+   * MSB
+   * 0-0------011-1-
+   * | |      ||| |
+   * | |      ||| +--- TCS:   External clock from pin.
+   * | |      ||+----- T32:   TIMER2 is bound with TIMER3 for 32 bit mode.
+   * | |      ++------ TCKPS: 1:8 Prescaler.
+   * | +-------------- TSIDL: Continue module operation in idle mode.
+   * +---------------- TON:   Timer OFF.
+   */
+  T2CON = (ON << _T2CON_TCS_POSITION) | (ON << _T2CON_T32_POSITION) |
+          (ON << _T2CON_TCKPS0_POSITION);
+
+  estimate = poll_frequency_counter_value(RECIPROCAL_PROBE_GATE) *
+             RECIPROCAL_COUNTER_PRESCALER * (FCY / RECIPROCAL_PROBE_GATE);
+  T2CONbits.TON = OFF;
+  RPINR3bits.T2CKR = 0b11111;
+
+  if ((estimate <= RECIPROCAL_PRESCALED_CAPTURE_FREQUENCY) &&
+      reciprocal_counting_pass(INPUT_CAPTURE_EVERY_RISING_EDGE, 1,
+                               measurement)) {
+    goto done;
+  }
+
+  if ((estimate <= RECIPROCAL_GATED_COUNT_FREQUENCY) &&
+      reciprocal_counting_pass(INPUT_CAPTURE_EVERY_16TH_RISING_EDGE, 16,
+                               measurement)) {
+    goto done;
+  }
+
+  /* Too fast for input capture, count edges within the minimum gate. */
+  stop_timers();
+  RPINR3bits.T2CKR = AUXPIN_RPIN;
+  T2CON = (ON << _T2CON_TCS_POSITION) | (ON << _T2CON_T32_POSITION) |
+          (ON << _T2CON_TCKPS0_POSITION);
+  measurement->edges = poll_frequency_counter_value(RECIPROCAL_MINIMUM_GATE) *
+                       RECIPROCAL_COUNTER_PRESCALER;
+  measurement->cycles = RECIPROCAL_MINIMUM_GATE;
+
+done:
+  /* Detach Timer2 Clock signal from the AUX pin. */
+  RPINR3bits.T2CKR = 0b11111;
+  stop_timers();
+}
+
+void bp_reciprocal_frequency_counter_setup(void) {
+  bp_frequency_measurement_t measurement;
+  uint64_t frequency;
+
+  if (state.mode == AUX_MODE_PWM) {
+    BPMSG1037;
+    return;
+  }
+
+  BPMSG1038;
+  bp_measure_frequency_reciprocal(&measurement);
+
+  if ((measurement.edges == 0) || (measurement.cycles == 0)) {
+    MSG_PWM_FREQUENCY_TOO_LOW;
+    return;
+  }
+
+  /* Frequency in mHz. */
+  frequency = ((uint64_t)measurement.edges * FCY * 1000) / measurement.cycles;
+  bp_write_dec_dword_friendly(frequency / 1000);
+  user_serial_transmit_character('.');
+  frequency = frequency % 1000;
+  if (frequency < 100) {
+    user_serial_transmit_character('0');
+  }
+  if (frequency < 10) {
+    user_serial_transmit_character('0');
+  }
+  bp_write_dec_word(frequency);
+  MSG_PWM_HZ_MARKER;
+}
+
+void bp_pulse_train_start(void) {
+  stop_timers();
+  AUXPIN_DIR = INPUT;
+  start_input_capture(INPUT_CAPTURE_EVERY_RISING_EDGE);
+  start_falling_edge_capture();
+  pulse_train_synchronised = false;
+}
+
+void bp_pulse_train_stop(void) {
+  stop_falling_edge_capture();
+  stop_input_capture();
+  stop_timers();
+}
+
+bp_pulse_train_status_t
+bp_pulse_train_measure(const uint32_t window,
+                       bp_pulse_train_measurement_t *measurement) {
+  uint32_t window_start;
+  uint32_t falling_edge;
+  uint32_t rising_edge;
+
+  measurement->periods = 0;
+  measurement->cycles = 0;
+  measurement->high_cycles = 0;
+
+  if (!pulse_train_synchronised) {
+    /* Restart the capture units to drop stale edges and overflow flags. */
+    bp_pulse_train_stop();
+    start_input_capture(INPUT_CAPTURE_EVERY_RISING_EDGE);
+    start_falling_edge_capture();
+
+    /* Wait for the rising edge opening the window. */
+    window_start = capture_timer_value();
+    while (IC1ICBNE == OFF) {
+      if (user_serial_ready_to_read()) {
+        return BP_PULSE_TRAIN_ABORTED;
+      }
+      if ((capture_timer_value() - window_start) > window) {
+        return BP_PULSE_TRAIN_NO_SIGNAL;
+      }
+    }
+
+    pulse_train_last_rising_edge = pop_rising_edge();
+    pulse_train_synchronised = true;
+  }
+
+  /*
+   * Consecutive windows share their boundary edge, so the time series has no
+   * gaps as long as the capture buffers do not overflow.
+   */
+  window_start = pulse_train_last_rising_edge;
+  rising_edge = window_start;
+
+  do {
+    /* Wait for the falling edge, skipping those preceding the window. */
+    do {
+      while (IC3ICBNE == OFF) {
+        if (user_serial_ready_to_read()) {
+          return BP_PULSE_TRAIN_ABORTED;
+        }
+        if ((capture_timer_value() - rising_edge) > window) {
+          pulse_train_synchronised = false;
+          return BP_PULSE_TRAIN_NO_SIGNAL;
+        }
+      }
+      falling_edge = pop_falling_edge();
+    } while ((int32_t)(falling_edge - rising_edge) < 0);
+
+    /* Wait for the rising edge closing the period. */
+    while (IC1ICBNE == OFF) {
+      if (user_serial_ready_to_read()) {
+        return BP_PULSE_TRAIN_ABORTED;
+      }
+      if ((capture_timer_value() - rising_edge) > window) {
+        pulse_train_synchronised = false;
+        return BP_PULSE_TRAIN_NO_SIGNAL;
+      }
+    }
+
+    if ((IC1ICOV == ON) || (IC3ICOV == ON)) {
+      pulse_train_synchronised = false;
+      return BP_PULSE_TRAIN_OVERFLOW;
+    }
+
+    measurement->high_cycles += falling_edge - rising_edge;
+    rising_edge = pop_rising_edge();
+    measurement->periods++;
+  } while ((rising_edge - window_start) < window);
+
+  measurement->cycles = rising_edge - window_start;
+  pulse_train_last_rising_edge = rising_edge;
+
+  return BP_PULSE_TRAIN_OK;
 }
 
 void bp_aux_pin_set_high_impedance(void) {
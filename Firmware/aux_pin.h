@@ -54,6 +54,49 @@
  */
 #define PWM_MAXIMUM_DUTY_CYCLE 100
 
+/**
+ * @brief Result of a reciprocal frequency measurement.
+ *
+ * The measured frequency in Hz is `edges * FCY / cycles`; if either field is
+ * zero no usable signal was found on the AUX pin.
+ */
+typedef struct {
+  /** Rising edges counted while the gate was open. */
+  uint32_t edges;
+  /** Instruction cycles elapsed between the first and the last counted edge. */
+  uint32_t cycles;
+} bp_frequency_measurement_t;
+
+/**
+ * @brief Outcome of a pulse train measurement window.
+ */
+typedef enum {
+  /** The window was measured. */
+  BP_PULSE_TRAIN_OK = 0,
+  /** Edges came in too fast, the window was discarded. */
+  BP_PULSE_TRAIN_OVERFLOW,
+  /** No complete period was seen within the window length. */
+  BP_PULSE_TRAIN_NO_SIGNAL,
+  /** A byte arrived from the host before the window was complete. */
+  BP_PULSE_TRAIN_ABORTED
+} bp_pulse_train_status_t;
+
+/**
+ * @brief Result of a pulse train measurement window.
+ *
+ * The frequency in Hz is `periods * FCY / cycles`, the average period is
+ * `cycles / periods` instruction cycles and the duty cycle is
+ * `high_cycles / cycles`.
+ */
+typedef struct {
+  /** Complete signal periods seen within the window. */
+  uint32_t periods;
+  /** Instruction cycles spanned by those periods. */
+  uint32_t cycles;
+  /** Instruction cycles the signal was high within those periods. */
+  uint32_t high_cycles;
+} bp_pulse_train_measurement_t;
+
 /**
  * @brief Updates the internal PWM generation variables.
  *
@@ -122,6 +165,49 @@ void bp_frequency_counter_setup(void);
  */
 unsigned long bp_measure_frequency(void);
 
+/**
+ * @brief Starts the setup process for a reciprocal frequency reading.
+ */
+void bp_reciprocal_frequency_counter_setup(void);
+
+/**
+ * @brief Measures the AUX pin frequency by reciprocal counting.
+ *
+ * Edges are timestamped with the input capture units and the gate is closed
+ * on the first edge past 100ms, so readings take a fraction of a second and
+ * keep sub-Hz resolution even on slow signals.  Signals too fast to capture
+ * fall back to a 100ms gated count.
+ *
+ * @param[out] measurement where to store the counted edges and cycles.
+ */
+void bp_measure_frequency_reciprocal(bp_frequency_measurement_t *measurement);
+
+/**
+ * @brief Starts timestamping both edges of the AUX pin signal.
+ */
+void bp_pulse_train_start(void);
+
+/**
+ * @brief Measures the AUX pin signal over the next window.
+ *
+ * Windows start on the rising edge that closed the previous one and end on
+ * the first rising edge past the given length, so back to back calls cover
+ * the signal without gaps.  Any pending byte from the host aborts the wait.
+ *
+ * @param[in]  window      the minimum window length, in instruction cycles.
+ * @param[out] measurement where to store the window measurement.
+ *
+ * @return the window measurement outcome.
+ */
+bp_pulse_train_status_t
+bp_pulse_train_measure(const uint32_t window,
+                       bp_pulse_train_measurement_t *measurement);
+
+/**
+ * @brief Stops timestamping the AUX pin signal edges.
+ */
+void bp_pulse_train_stop(void);
+
 /**
  * @brief Starts the setup process for generating a PWM signal.
  */
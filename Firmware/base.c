@@ -232,12 +232,94 @@ void bp_adc_probe(void) {
   AD1CON1bits.ADON = OFF;
 }
 
-void bp_adc_continuous_probe(void) {
+void bp_adc_summary_reset(bp_adc_summary_t *summary) {
+  summary->sum = 0;
+  summary->minimum = UINT16_MAX;
+  summary->maximum = 0;
+  summary->count = 0;
+}
+
+void bp_adc_summary_add(bp_adc_summary_t *summary, const uint16_t reading) {
+  summary->sum += reading;
+  if (reading < summary->minimum) {
+    summary->minimum = reading;
+  }
+  if (reading > summary->maximum) {
+    summary->maximum = reading;
+  }
+  summary->count++;
+}
+
+/**
+ * @brief Characters printed for a summarised voltmeter update.
+ *
+ * Average, minimum and maximum printed as "x.xxV [x.xxV-x.xxV]".
+ */
+#define ADC_SUMMARY_TEXT_LENGTH 19
+
+/**
+ * @brief Prints the average, minimum and maximum of an ADC readings summary.
+ *
+ * @param[in] summary the summary to print.
+ */
+static void write_adc_summary(const bp_adc_summary_t *summary) {
+  bp_write_voltage((summary->sum + (summary->count / 2)) / summary->count);
+  MSG_VOLTAGE_UNIT;
+  bp_write_string(" [");
+  bp_write_voltage(summary->minimum);
+  MSG_VOLTAGE_UNIT;
+  user_serial_transmit_character('-');
+  bp_write_voltage(summary->maximum);
+  MSG_VOLTAGE_UNIT;
+  user_serial_transmit_character(']');
+}
+
+void bp_adc_continuous_probe(const uint16_t window) {
+  bp_adc_summary_t summary;
   uint16_t measurement;
+  uint8_t index;
 
   MSG_ADC_VOLTMETER_MODE;
   MSG_ANY_KEY_TO_EXIT_PROMPT;
   MSG_ADC_VOLTAGE_PROBE_HEADER;
+
+  if (window > 1) {
+    /* Print an empty summary, to be erased by the first update. */
+    summary.sum = 0;
+    summary.minimum = 0;
+    summary.maximum = 0;
+    summary.count = 1;
+    write_adc_summary(&summary);
+
+    /* Turn the ADC on. */
+    AD1CON1bits.ADON = ON;
+
+    bp_adc_summary_reset(&summary);
+    while (!user_serial_ready_to_read()) {
+      bp_adc_summary_add(&summary, bp_read_adc(BP_ADC_PROBE));
+      if (summary.count < window) {
+        continue;
+      }
+
+      /* Erase previous summary. */
+      for (index = 0; index < ADC_SUMMARY_TEXT_LENGTH; index++) {
+        user_serial_transmit_character('\x08');
+      }
+
+      /* Print new summary. */
+      write_adc_summary(&summary);
+      bp_adc_summary_reset(&summary);
+    }
+
+    /* Turn the ADC off. */
+    AD1CON1bits.ADON = OFF;
+
+    /* Flush the incoming serial buffer. */
+    user_serial_read_byte();
+    bpBR;
+    return;
+  }
+
   bp_write_voltage(0);
   MSG_VOLTAGE_UNIT;
 
@@ -347,11 +429,7 @@ uint16_t bp_reverse_integer(const uint16_t value, const uint8_t bits) {
 }
 
 void bp_write_buffer(const uint8_t *buffer, const size_t length) {
-  size_t offset;
-
-  for (offset = 0; offset < length; offset++) {
-    user_serial_transmit_character(buffer[offset]);
-  }
+  user_serial_transmit_buffer(buffer, length);
 }
 
 void bp_write_string(const char *string) {
@@ -527,14 +605,101 @@ uint16_t bp_read_from_flash(const uint16_t page, const uint16_t address) {
 #ifdef BUSPIRATEV3
 
 /**
- * @brief User-facing serial ring buffer write pointer.
+ * @brief Dedicated storage for the user-facing serial transmission queue.
+ */
+static uint8_t user_serial_tx_queue_storage[BP_USER_SERIAL_TX_QUEUE_SIZE];
+
+/**
+ * @brief Storage currently backing the transmission queue.
+ *
+ * This is either user_serial_tx_queue_storage or, while a sniffer is running,
+ * the much larger terminal input buffer.
+ */
+static volatile uint8_t *user_serial_tx_queue = user_serial_tx_queue_storage;
+
+/**
+ * @brief Transmission queue index mask, its size minus one.
+ */
+static uint16_t user_serial_tx_queue_mask = BP_USER_SERIAL_TX_QUEUE_SIZE - 1;
+
+/**
+ * @brief Transmission queue write index, only updated by the producer.
+ */
+static volatile uint16_t user_serial_tx_queue_head;
+
+/**
+ * @brief Transmission queue read index, only updated by the interrupt handler.
+ */
+static volatile uint16_t user_serial_tx_queue_tail;
+
+/**
+ * @brief Whether the transmission queue is backed by the terminal buffer.
+ */
+static bool user_serial_tx_queue_borrowed;
+
+/**
+ * @brief Moves queued characters into the UART transmission buffer, as long as
+ * there is room for them.
+ *
+ * @warning Must be called with the transmission interrupt disabled, or from
+ * the transmission interrupt handler itself.
  */
-static uint16_t user_serial_ringbuffer_write;
+static void user_serial_tx_queue_drain(void) {
+  while ((user_serial_tx_queue_tail != user_serial_tx_queue_head) &&
+         (U1STAbits.UTXBF == NO)) {
+    U1TXREG = user_serial_tx_queue[user_serial_tx_queue_tail];
+    user_serial_tx_queue_tail =
+        (user_serial_tx_queue_tail + 1) & user_serial_tx_queue_mask;
+  }
+}
 
 /**
- * @brief User-facing serial ring buffer read pointer.
+ * @brief Appends a character to the transmission queue, if there is room.
+ *
+ * @param[in] character the character to append.
+ *
+ * @return YES if the character was queued, NO if the queue is full.
  */
-static uint16_t user_serial_ringbuffer_read;
+static bool user_serial_tx_queue_push(const uint8_t character) {
+  uint16_t next;
+
+  next = (user_serial_tx_queue_head + 1) & user_serial_tx_queue_mask;
+  if (next == user_serial_tx_queue_tail) {
+    return NO;
+  }
+
+  user_serial_tx_queue[user_serial_tx_queue_head] = character;
+  user_serial_tx_queue_head = next;
+
+  /*
+   * The interrupt handler disables itself once the queue is empty, so kick it
+   * again by raising the interrupt flag; the UART only raises it when a
+   * character moves out of the transmission buffer.
+   */
+  if (IEC0bits.U1TXIE == OFF) {
+    IFS0bits.U1TXIF = ON;
+    IEC0bits.U1TXIE = ON;
+  }
+
+  return YES;
+}
+
+/**
+ * @brief Switches the transmission queue to the given storage, once all the
+ * characters queued so far have been sent.
+ *
+ * @param[in] storage the storage to back the queue with.
+ * @param[in] size    the storage size in bytes, as a power of two.
+ */
+static void user_serial_tx_queue_attach(volatile uint8_t *storage,
+                                        const uint16_t size) {
+  user_serial_wait_transmission_done();
+
+  user_serial_tx_queue = storage;
+  user_serial_tx_queue_mask = size - 1;
+  user_serial_tx_queue_head = 0;
+  user_serial_tx_queue_tail = 0;
+}
 
 #ifndef BP_ENABLE_UART_SUPPORT
 
@@ -600,80 +765,51 @@ void user_serial_initialise(void) {
   U1STA = 0x0400;
 
   IFS0bits.U1RXIF = NO;
+
+  /* Set up the transmission queue, served by the transmission interrupt. */
+  IEC0bits.U1TXIE = OFF;
+  IFS0bits.U1TXIF = OFF;
+  user_serial_tx_queue = user_serial_tx_queue_storage;
+  user_serial_tx_queue_mask = BP_USER_SERIAL_TX_QUEUE_SIZE - 1;
+  user_serial_tx_queue_head = 0;
+  user_serial_tx_queue_tail = 0;
+  user_serial_tx_queue_borrowed = NO;
 }
 
-bool user_serial_transmit_done(void) { return U1STAbits.TRMT; }
+bool user_serial_transmit_done(void) {
+  return (user_serial_tx_queue_tail == user_serial_tx_queue_head) &&
+         U1STAbits.TRMT;
+}
 
 bool user_serial_ready_to_read(void) { return U1STAbits.URXDA; }
 
 void user_serial_ringbuffer_setup(void) {
-  user_serial_ringbuffer_read = 0;
-  user_serial_ringbuffer_write = 1;
+  /* Sniffers need a deep queue to ride out bursts, borrow the terminal one. */
+  user_serial_tx_queue_attach(bus_pirate_configuration.terminal_input,
+                              BP_TERMINAL_BUFFER_SIZE);
+  user_serial_tx_queue_borrowed = YES;
   bus_pirate_configuration.overflow = NO;
 }
 
-void user_serial_ringbuffer_process(void) {
-  uint16_t index;
-
-  /* No free slots? */
-  if (U1STAbits.UTXBF == YES) {
-    return;
+void user_serial_ringbuffer_release(void) {
+  /* Go back to the regular queue, once the terminal buffer was sent out. */
+  if (user_serial_tx_queue_borrowed) {
+    user_serial_tx_queue_attach(user_serial_tx_queue_storage,
+                                BP_USER_SERIAL_TX_QUEUE_SIZE);
+    user_serial_tx_queue_borrowed = NO;
   }
-  index = user_serial_ringbuffer_read + 1;
-
-  /* Wrap around if needed. */
-  if (index == BP_TERMINAL_BUFFER_SIZE) {
-    index = 0;
-  }
-
-  /* Nothing to do. */
-  if (index == user_serial_ringbuffer_write) {
-    return;
-  }
-
-  /* Send character to port. */
-  user_serial_ringbuffer_read = index;
-  U1TXREG =
-      bus_pirate_configuration.terminal_input[user_serial_ringbuffer_read];
 }
 
-void user_serial_ringbuffer_flush(void) {
-  uint16_t index;
-
-  for (;;) {
-    index = user_serial_ringbuffer_read + 1;
-
-    /* Wrap around if needed. */
-    if (index == BP_TERMINAL_BUFFER_SIZE) {
-      index = 0;
-    }
-
-    /* Nothing to do. */
-    if (index == user_serial_ringbuffer_write) {
-      return;
-    }
-
-    /* Send character. */
-    if (U1STAbits.UTXBF == NO) {
-      user_serial_ringbuffer_read = index;
-      U1TXREG =
-          bus_pirate_configuration.terminal_input[user_serial_ringbuffer_read];
-    }
-  }
+void user_serial_ringbuffer_process(void) {
+  /* The transmission interrupt does all the work now. */
 }
 
+void user_serial_ringbuffer_flush(void) { user_serial_wait_transmission_done(); }
+
 void user_serial_ringbuffer_append(const char character) {
-  if (user_serial_ringbuffer_write == user_serial_ringbuffer_read) {
+  if (!user_serial_tx_queue_push(character)) {
     BP_LEDMODE = LOW;
     bus_pirate_configuration.overflow = YES;
-    return;
-  }
-
-  bus_pirate_configuration.terminal_input[user_serial_ringbuffer_write] =
-      character;
-  user_serial_ringbuffer_write++;
-  if (user_serial_ringbuffer_write == BP_TERMINAL_BUFFER_SIZE) {
-    user_serial_ringbuffer_write = 0;
   }
 }
 
@@ -684,25 +820,80 @@ uint8_t user_serial_read_byte(void) {
   return LO8(U1RXREG);
 }
 
+/**
+ * @brief Byte handed out by user_serial_peek_span.
+ */
+static uint8_t user_serial_span_byte;
+
+/**
+ * @brief Whether user_serial_span_byte holds a byte not consumed yet.
+ */
+static bool user_serial_span_pending = NO;
+
+uint8_t user_serial_peek_span(const uint8_t **span) {
+  /* The UART has no buffer to expose, hand out one byte at a time. */
+  if (!user_serial_span_pending) {
+    user_serial_span_byte = user_serial_read_byte();
+    user_serial_span_pending = YES;
+  }
+
+  *span = &user_serial_span_byte;
+  return 1;
+}
+
+void user_serial_consume_span(const uint8_t count) {
+  if (count > 0) {
+    user_serial_span_pending = NO;
+  }
+}
+
 void user_serial_transmit_character(const char character) {
   /* Do not transmit if the board should be quiet. */
   if (bus_pirate_configuration.quiet) {
     return;
   }
 
-  /* Wait until transmission can take place. */
-  while (U1STAbits.UTXBF == ON) {
+  /*
+   * Wait until there is room in the queue.  Draining by hand as well keeps
+   * this from locking up when called with interrupts masked.
+   */
+  while (!user_serial_tx_queue_push(character)) {
+    IEC0bits.U1TXIE = OFF;
+    user_serial_tx_queue_drain();
+    IEC0bits.U1TXIE = ON;
   }
+}
+
+void user_serial_transmit_buffer(const uint8_t *buffer, const size_t length) {
+  size_t offset;
 
-  U1TXREG = character;
+  for (offset = 0; offset < length; offset++) {
+    user_serial_transmit_character(buffer[offset]);
+  }
 }
 
 void user_serial_wait_transmission_done(void) {
+  while (user_serial_tx_queue_tail != user_serial_tx_queue_head) {
+    IEC0bits.U1TXIE = OFF;
+    user_serial_tx_queue_drain();
+    IEC0bits.U1TXIE = ON;
+  }
+
   while (U1STAbits.TRMT == NO) {
   }
 }
 
-void user_serial_set_baud_rate(const uint16_t rate) { U1BRG = rate; }
+void user_serial_set_baud_rate(const uint16_t rate) {
+  /* Let queued characters out at the old rate first. */
+  user_serial_wait_transmission_done();
+  U1BRG = rate;
+}
+
+void user_serial_set_flush_policy(const uint8_t policy
+                                  __attribute__((unused))) {}
+
+void user_serial_override_flush_policy(const uint8_t policy
+                                       __attribute__((unused))) {}
 
 bool user_serial_check_overflow(void) { return U1STAbits.OERR; }
 
@@ -748,6 +939,16 @@ void __attribute__((interrupt, no_auto_psv)) _U1RXInterrupt(void) {
 }
 
 void __attribute__((interrupt, no_auto_psv)) _U1TXInterrupt(void) {
+  /* Serve the transmission queue unless an OpenOCD shift is in progress. */
+  if (UART1TXAvailable == UART1TXSent) {
+    IFS0bits.U1TXIF = OFF;
+    user_serial_tx_queue_drain();
+    if (user_serial_tx_queue_tail == user_serial_tx_queue_head) {
+      IEC0bits.U1TXIE = NO;
+    }
+    return;
+  }
+
   UART1TXSent++;
   if (UART1TXSent == UART1TXAvailable) {
     IEC0bits.U1TXIE = NO;
@@ -772,18 +973,47 @@ void user_serial_transmit_character(const char character) {
   putc_cdc(character);
 }
 
+void user_serial_transmit_buffer(const uint8_t *buffer, const size_t length) {
+  if (bus_pirate_configuration.quiet) {
+    return;
+  }
+
+  put_buffer_cdc(buffer, length);
+}
+
 void user_serial_ringbuffer_append(const char character) {
   user_serial_transmit_character(character);
 }
 
-bool user_serial_ready_to_read(void) { return cdc_Out_len || getOutReady(); }
+bool user_serial_ready_to_read(void) {
+  if (cdc_Out_len || getOutReady()) {
+    return YES;
+  }
+
+  /* Nothing left to process, the reply is complete. */
+  CDC_Flush_In_Idle();
+  return NO;
+}
 
 uint8_t user_serial_read_byte(void) { return getc_cdc(); }
 
+uint8_t user_serial_peek_span(const uint8_t **span) {
+  BYTE *packet;
+  BYTE count;
+
+  count = getspan_cdc(&packet);
+  *span = packet;
+  return count;
+}
+
+void user_serial_consume_span(const uint8_t count) { consume_cdc(count); }
+
 void user_serial_ringbuffer_flush(void) { CDC_Flush_In_Now(); }
 
 void user_serial_ringbuffer_setup(void) {}
 
+void user_serial_ringbuffer_release(void) {}
+
 void user_serial_ringbuffer_process(void) {}
 
 void user_serial_initialise(void) {}
@@ -796,6 +1026,14 @@ void user_serial_clear_overflow(void) {}
 
 void user_serial_set_baud_rate(const uint16_t rate __attribute__((unused))) {}
 
+void user_serial_set_flush_policy(const uint8_t policy) {
+  cdc_set_flush_policy(policy);
+}
+
+void user_serial_override_flush_policy(const uint8_t policy) {
+  cdc_override_flush_policy(policy);
+}
+
 bool user_serial_transmit_done(void) { return YES; }
 
 #endif /* BUSPIRATEV4 */
@@ -218,6 +218,35 @@ inline uint16_t bp_reverse_word(const uint16_t value);
  */
 void bp_reset_board_state(void);
 
+/**
+ * @brief Minimum, maximum and sum of a window of ADC readings.
+ */
+typedef struct {
+  /** Sum of the readings in the window. */
+  uint32_t sum;
+  /** Lowest reading in the window. */
+  uint16_t minimum;
+  /** Highest reading in the window. */
+  uint16_t maximum;
+  /** Number of readings in the window. */
+  uint16_t count;
+} bp_adc_summary_t;
+
+/**
+ * @brief Empties the given ADC readings summary.
+ *
+ * @param[out] summary the summary to reset.
+ */
+void bp_adc_summary_reset(bp_adc_summary_t *summary);
+
+/**
+ * @brief Adds an ADC reading to the given summary.
+ *
+ * @param[in,out] summary the summary to update.
+ * @param[in]     reading the ADC reading to add.
+ */
+void bp_adc_summary_add(bp_adc_summary_t *summary, const uint16_t reading);
+
 /**
  * @brief Reads a value from the ADC on the given channel.
  *
@@ -237,8 +266,13 @@ void bp_adc_probe(void);
 /**
  * @brief Takes ADC measurements and prints them to the serial port until a byte
  * is sent to the serial port.
+ *
+ * When the window is longer than one measurement, the average, minimum and
+ * maximum of each window are printed instead of every single measurement.
+ *
+ * @param[in] window how many measurements to summarise for each update.
  */
-void bp_adc_continuous_probe(void);
+void bp_adc_continuous_probe(const uint16_t window);
 
 /**
  * @brief Prints the given value to the user terminal according to the format
@@ -394,6 +428,21 @@ extern uint16_t UART1TXAvailable;
  * @{
  */
 
+/**
+ * @brief Output flush policies, see user_serial_set_flush_policy().
+ *
+ * These only matter for the v4 USB port, where output is sent in packets.
+ */
+
+/** Override only: let the current mode pick the policy. */
+#define USER_SERIAL_FLUSH_AUTOMATIC 0
+/** Send partial packets after a short fixed timeout only. */
+#define USER_SERIAL_FLUSH_ON_TIMEOUT 1
+/** Also send partial packets as soon as there is no more input to process. */
+#define USER_SERIAL_FLUSH_ON_REPLY 2
+/** Hold partial packets longer, to fill them up while streaming. */
+#define USER_SERIAL_FLUSH_WHEN_FULL 3
+
 /**
  * @brief Initialise the user-facing serial port.
  */
@@ -439,6 +488,26 @@ inline void user_serial_set_baud_rate(const uint16_t rate);
  */
 inline void user_serial_wait_transmission_done(void);
 
+/**
+ * @brief Selects the output flush policy suited to the current mode.
+ *
+ * Streaming modes switch to USER_SERIAL_FLUSH_WHEN_FULL while running and
+ * back to USER_SERIAL_FLUSH_ON_REPLY when done.  Ignored while a policy is
+ * forced with user_serial_override_flush_policy().
+ *
+ * @param[in] policy one of the USER_SERIAL_FLUSH_ON_* or
+ * USER_SERIAL_FLUSH_WHEN_FULL values.
+ */
+void user_serial_set_flush_policy(const uint8_t policy);
+
+/**
+ * @brief Forces an output flush policy regardless of the current mode.
+ *
+ * @param[in] policy the policy to use, or USER_SERIAL_FLUSH_AUTOMATIC to let
+ * the modes pick again.
+ */
+void user_serial_override_flush_policy(const uint8_t policy);
+
 /**
  * @brief Blocks execution until a byte arrives on the user-facing serial port
  * and returns said value.
@@ -447,6 +516,29 @@ inline void user_serial_wait_transmission_done(void);
  */
 uint8_t user_serial_read_byte(void);
 
+/**
+ * @brief Blocks execution until data is available on the user-facing serial
+ * port, and gives direct access to it.
+ *
+ * On v4 boards this is the unread part of the current USB packet, read in
+ * place from the endpoint buffer.  On v3 boards this is a single byte.
+ * Nothing is removed until user_serial_consume_span is called.
+ *
+ * @param[out] span set to point to the first available byte.
+ *
+ * @return how many bytes are available at span, at least one.
+ */
+uint8_t user_serial_peek_span(const uint8_t **span);
+
+/**
+ * @brief Removes bytes returned by user_serial_peek_span from the
+ * user-facing serial port input.
+ *
+ * @param[in] count how many bytes to remove, at most what
+ *                  user_serial_peek_span returned.
+ */
+void user_serial_consume_span(const uint8_t count);
+
 /**
  * @brief Writes the first available byte from the transmission queue into the
  * serial port transmission buffer register.
@@ -454,13 +546,28 @@ uint8_t user_serial_read_byte(void);
 void user_serial_process_transmission_interrupt(void);
 
 /**
- * @brief Writes the given character to the user-facing serial port, blocking
- * until the transmission completes.
+ * @brief Writes the given character to the user-facing serial port.
+ *
+ * On v3 boards the character is appended to a queue emptied by the UART
+ * transmission interrupt, blocking only while the queue is full.
  *
  * @param[in] character the character to write.
  */
 void user_serial_transmit_character(const char character);
 
+/**
+ * @brief Writes the given buffer to the user-facing serial port.
+ *
+ * On v4 boards the data is copied straight into the USB endpoint buffers and
+ * sent in full-sized packets.  A trailing partial packet is kept for the
+ * next write and goes out when the output is flushed, like single characters
+ * do.
+ *
+ * @param[in] buffer the data to write.
+ * @param[in] length how many bytes to write.
+ */
+void user_serial_transmit_buffer(const uint8_t *buffer, const size_t length);
+
 /**
  * @}
  */
@@ -476,6 +583,15 @@ void user_serial_transmit_character(const char character);
  */
 void user_serial_ringbuffer_setup(void);
 
+/**
+ * @brief Releases the user-facing serial port ringbuffer once a sniffer is
+ * done with it.
+ *
+ * On v3 boards this waits for the sniffed data to be sent, then hands the
+ * terminal buffer the ringbuffer was borrowing back to its owner.
+ */
+void user_serial_ringbuffer_release(void);
+
 /**
  * @brief Flushes the user-facing serial port ringbuffer.
  */
@@ -491,6 +607,9 @@ void user_serial_ringbuffer_append(const char character);
 
 /**
  * @brief Transmits the first available character from the ringbuffer.
+ *
+ * On v3 boards the ringbuffer is emptied by the UART transmission interrupt,
+ * so this does nothing and is only kept for the sniffers' polling loops.
  */
 void user_serial_ringbuffer_process(void);
 
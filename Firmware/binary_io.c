@@ -66,6 +66,250 @@ extern bus_pirate_configuration_t bus_pirate_configuration;
  */
 static void send_binary_io_mode_identifier(void);
 
+/**
+ * Port bits driven by the waveform playback engine.
+ */
+#define BINARY_IO_WAVEFORM_PINS (AUX + MOSI + CLK + MISO + CS)
+
+/**
+ * Shortest waveform step allowed, in instruction cycles.
+ *
+ * This leaves enough room for the timer interrupt to sample the pins and load
+ * the next step (250kHz).
+ */
+#define BINARY_IO_WAVEFORM_MINIMUM_TICKS 64
+
+/**
+ * Waveform playback step, as stored in the terminal buffer.
+ */
+typedef struct {
+  /**
+   * Port bits to set for this step, replaced by the port state read right
+   * before the step ends.
+   */
+  uint16_t pins;
+
+  /** Timer #1 period for this step (how many instruction cycles, minus 1). */
+  uint16_t ticks;
+} binary_io_waveform_step_t;
+
+/**
+ * How many waveform steps fit in the terminal buffer.
+ */
+#define BINARY_IO_WAVEFORM_MAXIMUM_STEPS                                       \
+  (BP_TERMINAL_BUFFER_SIZE / sizeof(binary_io_waveform_step_t))
+
+/**
+ * The waveform step currently being played.
+ */
+static volatile binary_io_waveform_step_t *waveform_step;
+
+/**
+ * How many waveform steps still have to end, including the current one.
+ */
+static volatile uint16_t waveform_steps_left;
+
+/**
+ * How many bits a timer period is shifted left by to get instruction cycles,
+ * for each timer prescaler selection (1:1, 1:8, 1:64, 1:256).
+ */
+static const uint8_t BINARY_IO_TIMER_PRESCALER_SHIFTS[] = {0, 3, 6, 8};
+
+/**
+ * Shortest pin capture sampling period allowed, in instruction cycles.
+ *
+ * Each sample costs an interrupt, so the rate is capped to leave enough
+ * cycles for the main loop to pack and send samples out (100kHz).
+ */
+#define BINARY_IO_PIN_CAPTURE_MINIMUM_PERIOD (FCY / 100000UL)
+
+/**
+ * How many bits each captured pins sample takes in the stream.
+ */
+#define BINARY_IO_PIN_CAPTURE_SAMPLE_BITS 5
+
+/**
+ * Instruction cycles per millisecond, the frequency streaming interval unit.
+ */
+#define BINARY_IO_FREQUENCY_STREAM_INTERVAL_UNIT (FCY / 1000UL)
+
+/**
+ * Shortest ADC streaming conversion period allowed, in instruction cycles.
+ *
+ * Leaves room for sampling and conversion, plus the timer #3 interrupt that
+ * moves completed frames into the ring buffer (100kHz).
+ */
+#define BINARY_IO_ADC_STREAM_MINIMUM_PERIOD (FCY / 100000UL)
+
+/**
+ * How many analog channels can be streamed at once.
+ */
+#define BINARY_IO_ADC_STREAM_CHANNELS 4
+
+/**
+ * How many samples each streamed block carries.
+ *
+ * A multiple of every possible channels count, so blocks always hold whole
+ * frames, and of 4, so samples pack into whole bytes.
+ */
+#define BINARY_IO_ADC_STREAM_BLOCK_SAMPLES 12
+
+/**
+ * ADC streaming block, as stored in the terminal buffer.
+ */
+typedef struct {
+  /** Samples, in frames ordered as PROBE|VPU|3V3|5V0. */
+  uint16_t samples[BINARY_IO_ADC_STREAM_BLOCK_SAMPLES];
+
+  /** Block sequence number, counting dropped blocks as well. */
+  uint8_t sequence;
+} binary_io_adc_stream_block_t;
+
+/**
+ * How many ADC streaming blocks fit in the terminal buffer.
+ */
+#define BINARY_IO_ADC_STREAM_BLOCKS                                            \
+  (BP_TERMINAL_BUFFER_SIZE / sizeof(binary_io_adc_stream_block_t))
+
+/**
+ * Analog inputs selectable for streaming, in stream order.
+ */
+static const uint8_t binary_io_adc_stream_inputs[BINARY_IO_ADC_STREAM_CHANNELS] =
+    {BP_ADC_PROBE, BP_ADC_VPU, BP_ADC_3V3, BP_ADC_5V0};
+
+/**
+ * ADC buffer slot of each streamed channel, in stream order.
+ */
+static uint8_t adc_stream_slots[BINARY_IO_ADC_STREAM_CHANNELS];
+
+/**
+ * How many channels are being streamed.
+ */
+static uint8_t adc_stream_channels;
+
+/**
+ * Streamed blocks ring buffer write index.
+ */
+static volatile uint16_t adc_stream_head;
+
+/**
+ * Streamed blocks ring buffer read index.
+ */
+static volatile uint16_t adc_stream_tail;
+
+/**
+ * How many samples of the block at adc_stream_head are filled in.
+ */
+static volatile uint8_t adc_stream_filled;
+
+/**
+ * Sequence number of the next block to be filled in.
+ */
+static volatile uint8_t adc_stream_sequence;
+
+/**
+ * Flag indicating whether blocks were dropped because the ring buffer was
+ * full.
+ */
+static volatile bool adc_stream_overrun;
+
+/**
+ * Flag indicating whether timer #1 interrupts capture pins samples rather
+ * than play a waveform.
+ */
+static volatile bool pin_capture_running;
+
+/**
+ * Captured pins samples ring buffer write index.
+ */
+static volatile uint16_t pin_capture_head;
+
+/**
+ * Captured pins samples ring buffer read index.
+ */
+static volatile uint16_t pin_capture_tail;
+
+/**
+ * Flag indicating whether samples were dropped because the ring buffer was
+ * full.
+ */
+static volatile bool pin_capture_overrun;
+
+/**
+ * Converts a BBIO pins byte (AUX|MOSI|CLK|MISO|CS) into port bits.
+ *
+ * @param[in] pins the BBIO pins byte to convert.
+ *
+ * @return the corresponding IOPOR/IOLAT bits.
+ */
+static uint16_t binary_io_pins_to_port(const uint8_t pins);
+
+/**
+ * Converts port bits into a BBIO pins byte (AUX|MOSI|CLK|MISO|CS).
+ *
+ * @param[in] port the IOPOR value to convert.
+ *
+ * @return the corresponding BBIO pins byte.
+ */
+static uint8_t binary_io_port_to_pins(const uint16_t port);
+
+/**
+ * Uploads a waveform into the terminal buffer, plays it, and sends back the
+ * pins state sampled at the end of each step.
+ */
+static void binary_io_play_waveform(void);
+
+/**
+ * Streams the pins state sampled at a timer-driven rate, until any byte is
+ * received.
+ */
+static void binary_io_capture_pins(void);
+
+/**
+ * Sends a 32 bits value, most significant byte first.
+ *
+ * @param[in] value the value to send.
+ */
+static void binary_io_send_dword(const uint32_t value);
+
+/**
+ * Streams frequency, period and duty cycle measurements of the AUX pin signal
+ * at a host-provided interval, until any byte is received.
+ */
+static void binary_io_stream_frequency(void);
+
+/**
+ * Streams packed ADC samples of the selected channels, converted at a
+ * timer-driven rate, until any byte is received.
+ */
+static void binary_io_stream_adc(void);
+
+/**
+ * Streams the minimum, maximum and sum of the selected channels samples over
+ * windows of a host-provided frames count, until any byte is received.
+ */
+static void binary_io_summarise_adc(void);
+
+/**
+ * Starts timer-triggered conversions of the selected channels into the
+ * terminal buffer ring.
+ *
+ * @param[in] channels  the channels mask, PROBE|VPU|3V3|5V0 LSB first.
+ * @param[in] prescaler the timer #3 prescaler selection.
+ * @param[in] period    the timer #3 period, in prescaled instruction cycles,
+ *                      0 meaning 65536.
+ *
+ * @return true if conversions were started, false if the setup is invalid.
+ */
+static bool binary_io_adc_stream_start(const uint8_t channels,
+                                       const uint8_t prescaler,
+                                       const uint16_t period);
+
+/**
+ * Stops timer-triggered conversions and restores the ADC setup.
+ */
+static void binary_io_adc_stream_stop(void);
+
 // unsigned char binBBpindirectionset(unsigned char inByte);
 // unsigned char binBBpinset(unsigned char inByte);
 void binSelfTest(bool jumper_test);
@@ -108,6 +352,8 @@ Commands:
 00010110 // ADC Stop
 00011000 // XSVF Player
 // End added JM
+00011001 // Waveform playback
+00011010 // Streaming pins capture
 //
 010xxxxx //set input(1)/output(0) pin state (returns pin read)
  */
@@ -179,6 +425,7 @@ void binBB(void) {
         binReset();
         send_binary_io_mode_identifier();
       } else if (inByte == 0b1111) { // return to terminal
+        user_serial_override_flush_policy(USER_SERIAL_FLUSH_AUTOMATIC);
         user_serial_transmit_character(1);
         BP_LEDMODE = 0; // light MODE LED
         user_serial_wait_transmission_done();  // wait untill TX finishes
@@ -238,6 +485,7 @@ void binBB(void) {
         user_serial_transmit_character(i);                    // send lower 8 bits
       } else if (inByte == 0b10101) {  // ADC reading (x/1024)*6.6volts
         AD1CON1bits.ADON = 1;          // turn ADC ON
+        user_serial_set_flush_policy(USER_SERIAL_FLUSH_WHEN_FULL);
         while (1) {
           i = bp_read_adc(BP_ADC_PROBE); // take measurement
           user_serial_wait_transmission_done();
@@ -250,6 +498,7 @@ void binBB(void) {
             break;
           }
         }
+        user_serial_set_flush_policy(USER_SERIAL_FLUSH_ON_REPLY);
         AD1CON1bits.ADON = 0;         // turn ADC OFF
       } else if (inByte == 0b10110) { // binary frequency count access
         unsigned long l;
@@ -258,6 +507,11 @@ void binBB(void) {
         user_serial_transmit_character((l >> (8 * 2)));
         user_serial_transmit_character((l >> (8 * 1)));
         user_serial_transmit_character((l));
+      } else if (inByte == 0b10111) { // reciprocal frequency measurement
+        bp_frequency_measurement_t measurement;
+        bp_measure_frequency_reciprocal(&measurement);
+        binary_io_send_dword(measurement.edges);
+        binary_io_send_dword(measurement.cycles);
 //--- Added JM
 #ifdef BUSPIRATEV4
       } else if (inByte == 0b11000) { // XSVF Player to program CPLD
@@ -266,6 +520,24 @@ void binBB(void) {
         jtag();
 #endif
         //--- End added JM
+      } else if (inByte == 0b11001) { // waveform playback
+        binary_io_play_waveform();
+      } else if (inByte == 0b11010) { // streaming pins capture
+        binary_io_capture_pins();
+      } else if (inByte == 0b11011) { // streaming frequency measurement
+        binary_io_stream_frequency();
+      } else if (inByte == 0b11100) { // streaming ADC measurement
+        binary_io_stream_adc();
+      } else if (inByte == 0b11101) { // streaming ADC summaries
+        binary_io_summarise_adc();
+      } else if (inByte == 0b11110) { // output flush policy
+        i = getRXbyte();
+        if (i > USER_SERIAL_FLUSH_WHEN_FULL) {
+          REPORT_IO_FAILURE();
+        } else {
+          user_serial_override_flush_policy(i);
+          REPORT_IO_SUCCESS();
+        }
       } else if ((inByte >> 5) & 0b010) { // set pin direction, return read
         user_serial_transmit_character(binBBpindirectionset(inByte));
       } else { // unknown command, error
@@ -278,6 +550,578 @@ void binBB(void) {
   }   // while
 } // function
 
+uint16_t binary_io_pins_to_port(const uint8_t pins) {
+  uint16_t port;
+
+  port = 0;
+  if (pins & 0b10000) {
+    port |= AUX;
+  }
+  if (pins & 0b1000) {
+    port |= MOSI;
+  }
+  if (pins & 0b100) {
+    port |= CLK;
+  }
+  if (pins & 0b10) {
+    port |= MISO;
+  }
+  if (pins & 0b1) {
+    port |= CS;
+  }
+
+  return port;
+}
+
+uint8_t binary_io_port_to_pins(const uint16_t port) {
+  uint8_t pins;
+
+  pins = 0;
+  if (port & AUX) {
+    pins |= 0b10000;
+  }
+  if (port & MOSI) {
+    pins |= 0b1000;
+  }
+  if (port & CLK) {
+    pins |= 0b100;
+  }
+  if (port & MISO) {
+    pins |= 0b10;
+  }
+  if (port & CS) {
+    pins |= 0b1;
+  }
+
+  return pins;
+}
+
+void __attribute__((interrupt, no_auto_psv)) _T1Interrupt(void) {
+  if (pin_capture_running) {
+    uint16_t next;
+
+    next = (pin_capture_head + 1) & (BP_TERMINAL_BUFFER_SIZE - 1);
+    if (next == pin_capture_tail) {
+      /* The buffer is full, drop the sample. */
+      pin_capture_overrun = true;
+    } else {
+      bus_pirate_configuration.terminal_input[pin_capture_head] =
+          binary_io_port_to_pins(IOPOR);
+      pin_capture_head = next;
+    }
+
+    IFS0bits.T1IF = OFF;
+    return;
+  }
+
+  /* Sample the pins right before the step ends. */
+  waveform_step->pins = IOPOR;
+
+  if (--waveform_steps_left == 0) {
+    T1CON = 0;
+    IEC0bits.T1IE = OFF;
+  } else {
+    /* Load the next step, the timer has already restarted counting. */
+    waveform_step++;
+    IOLAT = (IOLAT & ~BINARY_IO_WAVEFORM_PINS) | waveform_step->pins;
+    PR1 = waveform_step->ticks;
+  }
+
+  IFS0bits.T1IF = OFF;
+}
+
+void __attribute__((interrupt, no_auto_psv)) _T3Interrupt(void) {
+  volatile uint16_t *buffer;
+  volatile binary_io_adc_stream_block_t *block;
+  uint16_t next;
+  uint8_t index;
+
+  IFS0bits.T3IF = OFF;
+
+  /* Timer #3 triggers every conversion, pick up completed frames only. */
+  if (IFS0bits.AD1IF == OFF) {
+    return;
+  }
+  IFS0bits.AD1IF = OFF;
+
+  /* The frame just completed sits in the half not being filled now. */
+  buffer = &ADC1BUF0;
+  if (AD1CON2bits.BUFS == OFF) {
+    buffer += 8;
+  }
+
+  block = (volatile binary_io_adc_stream_block_t *)
+              bus_pirate_configuration.terminal_input +
+          adc_stream_head;
+  for (index = 0; index < adc_stream_channels; index++) {
+    block->samples[adc_stream_filled++] = buffer[adc_stream_slots[index]];
+  }
+
+  if (adc_stream_filled < BINARY_IO_ADC_STREAM_BLOCK_SAMPLES) {
+    return;
+  }
+
+  adc_stream_filled = 0;
+  block->sequence = adc_stream_sequence++;
+
+  next = adc_stream_head + 1;
+  if (next == BINARY_IO_ADC_STREAM_BLOCKS) {
+    next = 0;
+  }
+  if (next == adc_stream_tail) {
+    /* The buffer is full, drop the block. */
+    adc_stream_overrun = true;
+  } else {
+    adc_stream_head = next;
+  }
+}
+
+void binary_io_play_waveform(void) {
+  volatile binary_io_waveform_step_t *steps;
+  uint16_t steps_count;
+  uint16_t ticks;
+  uint16_t index;
+
+  steps = (volatile binary_io_waveform_step_t *)
+              bus_pirate_configuration.terminal_input;
+
+  steps_count = getRXbyte() << 8;
+  steps_count |= getRXbyte();
+
+  if ((steps_count == 0) || (steps_count > BINARY_IO_WAVEFORM_MAXIMUM_STEPS)) {
+    REPORT_IO_FAILURE();
+    return;
+  }
+
+  /* Each step is a pins byte followed by its length in cycles, MSB first. */
+  for (index = 0; index < steps_count; index++) {
+    steps[index].pins = binary_io_pins_to_port(getRXbyte());
+    ticks = getRXbyte() << 8;
+    ticks |= getRXbyte();
+    if (ticks < BINARY_IO_WAVEFORM_MINIMUM_TICKS) {
+      ticks = BINARY_IO_WAVEFORM_MINIMUM_TICKS;
+    }
+    steps[index].ticks = ticks - 1;
+  }
+
+  /* Set up timer #1 to run at FCY, and its interrupt. */
+  T1CON = 0;
+  TMR1 = 0;
+  PR1 = steps[0].ticks;
+  IPC0bits.T1IP = 6;
+  IFS0bits.T1IF = OFF;
+
+  waveform_step = steps;
+  waveform_steps_left = steps_count;
+
+  /* Apply the first step and start playing. */
+  IOLAT = (IOLAT & ~BINARY_IO_WAVEFORM_PINS) | steps[0].pins;
+  IEC0bits.T1IE = ON;
+  T1CONbits.TON = ON;
+
+  while (waveform_steps_left != 0) {
+  }
+
+  /* Send the sampled pins back. */
+  REPORT_IO_SUCCESS();
+  for (index = 0; index < steps_count; index++) {
+    user_serial_transmit_character(binary_io_port_to_pins(steps[index].pins));
+  }
+}
+
+void binary_io_capture_pins(void) {
+  uint32_t bits;
+  uint8_t bits_count;
+  uint8_t prescaler;
+  uint16_t period;
+  uint32_t cycles;
+  bool stop;
+
+  /* Timer #1 prescaler selection (1:1, 1:8, 1:64, 1:256) and period. */
+  prescaler = getRXbyte() & 0b11;
+  period = getRXbyte() << 8;
+  period |= getRXbyte();
+
+  /* A period of 0 stands for 65536 cycles, PR1 wraps around to 0xFFFF. */
+  cycles = ((period == 0) ? 65536UL : period)
+           << BINARY_IO_TIMER_PRESCALER_SHIFTS[prescaler];
+  if (cycles < BINARY_IO_PIN_CAPTURE_MINIMUM_PERIOD) {
+    REPORT_IO_FAILURE();
+    return;
+  }
+
+  REPORT_IO_SUCCESS();
+
+  pin_capture_head = 0;
+  pin_capture_tail = 0;
+  pin_capture_overrun = false;
+  pin_capture_running = true;
+  user_serial_set_flush_policy(USER_SERIAL_FLUSH_WHEN_FULL);
+
+  /* Set up timer #1 and its interrupt. */
+  T1CON = 0;
+  T1CONbits.TCKPS = prescaler;
+  TMR1 = 0;
+  PR1 = period - 1;
+  IPC0bits.T1IP = 6;
+  IFS0bits.T1IF = OFF;
+  IEC0bits.T1IE = ON;
+  T1CONbits.TON = ON;
+
+  /*
+   * Pack samples LSB first, eight samples every five bytes.  The stop request
+   * is only honoured on a group boundary, so the stream is always made of
+   * whole groups.
+   */
+  bits = 0;
+  bits_count = 0;
+  stop = false;
+  while (!stop || (bits_count != 0)) {
+    if (!stop && user_serial_ready_to_read()) {
+      user_serial_read_byte();
+      stop = true;
+    }
+
+    if (pin_capture_tail == pin_capture_head) {
+      continue;
+    }
+
+    bits |= (uint32_t)bus_pirate_configuration.terminal_input[pin_capture_tail]
+            << bits_count;
+    bits_count += BINARY_IO_PIN_CAPTURE_SAMPLE_BITS;
+    pin_capture_tail = (pin_capture_tail + 1) & (BP_TERMINAL_BUFFER_SIZE - 1);
+
+    while (bits_count >= 8) {
+      user_serial_transmit_character(bits & 0xFF);
+      bits >>= 8;
+      bits_count -= 8;
+    }
+  }
+
+  T1CON = 0;
+  IEC0bits.T1IE = OFF;
+  IFS0bits.T1IF = OFF;
+  pin_capture_running = false;
+  user_serial_set_flush_policy(USER_SERIAL_FLUSH_ON_REPLY);
+
+  /* Trailing status byte. */
+  if (pin_capture_overrun) {
+    REPORT_IO_FAILURE();
+  } else {
+    REPORT_IO_SUCCESS();
+  }
+}
+
+void binary_io_send_dword(const uint32_t value) {
+  user_serial_transmit_character(value >> 24);
+  user_serial_transmit_character(value >> 16);
+  user_serial_transmit_character(value >> 8);
+  user_serial_transmit_character(value);
+}
+
+void binary_io_stream_frequency(void) {
+  bp_pulse_train_measurement_t measurement;
+  bp_pulse_train_status_t status;
+  uint16_t interval;
+  uint8_t sequence;
+
+  /* Measurement interval, in milliseconds. */
+  interval = getRXbyte() << 8;
+  interval |= getRXbyte();
+
+  if (interval == 0) {
+    REPORT_IO_FAILURE();
+    return;
+  }
+
+  REPORT_IO_SUCCESS();
+
+  user_serial_set_flush_policy(USER_SERIAL_FLUSH_WHEN_FULL);
+  bp_pulse_train_start();
+  sequence = 0;
+  for (;;) {
+    status = bp_pulse_train_measure(
+        (uint32_t)interval * BINARY_IO_FREQUENCY_STREAM_INTERVAL_UNIT,
+        &measurement);
+    if (status == BP_PULSE_TRAIN_ABORTED) {
+      break;
+    }
+
+    /* Sequence number, status, periods, cycles, high cycles. */
+    user_serial_transmit_character(sequence++);
+    user_serial_transmit_character(status);
+    binary_io_send_dword(measurement.periods);
+    binary_io_send_dword(measurement.cycles);
+    binary_io_send_dword(measurement.high_cycles);
+
+    if (user_serial_ready_to_read()) {
+      break;
+    }
+  }
+  bp_pulse_train_stop();
+  user_serial_set_flush_policy(USER_SERIAL_FLUSH_ON_REPLY);
+
+  user_serial_read_byte();
+  REPORT_IO_SUCCESS();
+}
+
+bool binary_io_adc_stream_start(const uint8_t channels, const uint8_t prescaler,
+                                const uint16_t period) {
+  uint16_t selection;
+  uint32_t cycles;
+  uint8_t index;
+  uint8_t other;
+
+  /* A period of 0 stands for 65536 cycles, PR3 wraps around to 0xFFFF. */
+  cycles = ((period == 0) ? 65536UL : period)
+           << BINARY_IO_TIMER_PRESCALER_SHIFTS[prescaler & 0b11];
+  if ((channels == 0) || (cycles < BINARY_IO_ADC_STREAM_MINIMUM_PERIOD)) {
+    return false;
+  }
+
+  /*
+   * The ADC scans inputs in ascending order, so work out where each selected
+   * channel lands in the buffer to send them out in a fixed order instead.
+   */
+  selection = 0;
+  adc_stream_channels = 0;
+  for (index = 0; index < BINARY_IO_ADC_STREAM_CHANNELS; index++) {
+    if (channels & (1 << index)) {
+      selection |= 1 << binary_io_adc_stream_inputs[index];
+      adc_stream_slots[adc_stream_channels] = 0;
+      for (other = 0; other < BINARY_IO_ADC_STREAM_CHANNELS; other++) {
+        if ((channels & (1 << other)) &&
+            (binary_io_adc_stream_inputs[other] <
+             binary_io_adc_stream_inputs[index])) {
+          adc_stream_slots[adc_stream_channels]++;
+        }
+      }
+      adc_stream_channels++;
+    }
+  }
+
+  adc_stream_head = 0;
+  adc_stream_tail = 0;
+  adc_stream_filled = 0;
+  adc_stream_sequence = 0;
+  adc_stream_overrun = false;
+
+  /*
+   * Timer #3 compare ends sampling and starts a conversion, sampling restarts
+   * automatically afterwards.  Inputs are scanned one frame per interrupt
+   * flag, alternating between the two buffer halves.
+   */
+  AD1CON1bits.ADON = OFF;
+  AD1CSSL = selection;
+  AD1CON2 = 0;
+  AD1CON2bits.CSCNA = ON;
+  AD1CON2bits.BUFM = ON;
+  AD1CON2bits.SMPI = adc_stream_channels - 1;
+  AD1CON1bits.SSRC = 0b010;
+  AD1CON1bits.ASAM = ON;
+  IFS0bits.AD1IF = OFF;
+  AD1CON1bits.ADON = ON;
+
+  /* Set up timer #3 and its interrupt. */
+  T3CON = 0;
+  T3CONbits.TCKPS = prescaler;
+  TMR3 = 0;
+  PR3 = period - 1;
+  IPC2bits.T3IP = 6;
+  IFS0bits.T3IF = OFF;
+  IEC0bits.T3IE = ON;
+  T3CONbits.TON = ON;
+
+  user_serial_set_flush_policy(USER_SERIAL_FLUSH_WHEN_FULL);
+
+  return true;
+}
+
+void binary_io_adc_stream_stop(void) {
+  T3CON = 0;
+  IEC0bits.T3IE = OFF;
+  IFS0bits.T3IF = OFF;
+
+  /* Restore the ADC to single software-triggered conversions. */
+  AD1CON1bits.ADON = OFF;
+  AD1CON1bits.ASAM = OFF;
+  AD1CON1bits.SSRC = 0b111;
+  AD1CON2 = 0;
+  AD1CSSL = 0;
+  IFS0bits.AD1IF = OFF;
+
+  user_serial_set_flush_policy(USER_SERIAL_FLUSH_ON_REPLY);
+}
+
+void binary_io_stream_adc(void) {
+  const volatile binary_io_adc_stream_block_t *block;
+  uint32_t bits;
+  uint8_t bits_count;
+  uint8_t channels;
+  uint8_t prescaler;
+  uint16_t period;
+  uint8_t index;
+  bool stop;
+
+  /* Channels mask (PROBE|VPU|3V3|5V0, LSB first), then timer #3 setup. */
+  channels = getRXbyte() & 0b1111;
+  prescaler = getRXbyte() & 0b11;
+  period = getRXbyte() << 8;
+  period |= getRXbyte();
+
+  if (!binary_io_adc_stream_start(channels, prescaler, period)) {
+    REPORT_IO_FAILURE();
+    return;
+  }
+
+  REPORT_IO_SUCCESS();
+
+  /*
+   * Each block is its sequence number followed by its samples packed LSB
+   * first, four samples every five bytes.  The stop request is only honoured
+   * on a block boundary.
+   */
+  stop = false;
+  while (!stop) {
+    if (user_serial_ready_to_read()) {
+      user_serial_read_byte();
+      stop = true;
+    }
+
+    while (adc_stream_tail != adc_stream_head) {
+      block = (const volatile binary_io_adc_stream_block_t *)
+                  bus_pirate_configuration.terminal_input +
+              adc_stream_tail;
+
+      user_serial_transmit_character(block->sequence);
+      bits = 0;
+      bits_count = 0;
+      for (index = 0; index < BINARY_IO_ADC_STREAM_BLOCK_SAMPLES; index++) {
+        bits |= (uint32_t)block->samples[index] << bits_count;
+        bits_count += 10;
+        while (bits_count >= 8) {
+          user_serial_transmit_character(bits & 0xFF);
+          bits >>= 8;
+          bits_count -= 8;
+        }
+      }
+
+      adc_stream_tail = (adc_stream_tail + 1 == BINARY_IO_ADC_STREAM_BLOCKS)
+                            ? 0
+                            : adc_stream_tail + 1;
+      if (stop) {
+        break;
+      }
+    }
+  }
+
+  binary_io_adc_stream_stop();
+
+  /* Trailing status byte. */
+  if (adc_stream_overrun) {
+    REPORT_IO_FAILURE();
+  } else {
+    REPORT_IO_SUCCESS();
+  }
+}
+
+void binary_io_summarise_adc(void) {
+  const volatile binary_io_adc_stream_block_t *block;
+  bp_adc_summary_t summaries[BINARY_IO_ADC_STREAM_CHANNELS];
+  uint8_t channels;
+  uint8_t prescaler;
+  uint16_t period;
+  uint16_t window;
+  uint16_t frames;
+  uint8_t expected_sequence;
+  uint8_t sequence;
+  uint8_t index;
+  uint8_t channel;
+  bool dropped;
+
+  /* Same setup as the ADC stream, followed by the frames count per window. */
+  channels = getRXbyte() & 0b1111;
+  prescaler = getRXbyte() & 0b11;
+  period = getRXbyte() << 8;
+  period |= getRXbyte();
+  window = getRXbyte() << 8;
+  window |= getRXbyte();
+
+  if ((window == 0) ||
+      !binary_io_adc_stream_start(channels, prescaler, period)) {
+    REPORT_IO_FAILURE();
+    return;
+  }
+
+  REPORT_IO_SUCCESS();
+
+  for (channel = 0; channel < adc_stream_channels; channel++) {
+    bp_adc_summary_reset(&summaries[channel]);
+  }
+  frames = 0;
+  sequence = 0;
+  expected_sequence = 0;
+  dropped = false;
+
+  /* A window still being accumulated is discarded when a byte comes in. */
+  while (!user_serial_ready_to_read()) {
+    if (adc_stream_tail == adc_stream_head) {
+      continue;
+    }
+
+    block = (const volatile binary_io_adc_stream_block_t *)
+                bus_pirate_configuration.terminal_input +
+            adc_stream_tail;
+
+    /* A sequence gap means the window misses whole blocks. */
+    if (block->sequence != expected_sequence) {
+      dropped = true;
+    }
+    expected_sequence = block->sequence + 1;
+
+    channel = 0;
+    for (index = 0; index < BINARY_IO_ADC_STREAM_BLOCK_SAMPLES; index++) {
+      bp_adc_summary_add(&summaries[channel], block->samples[index]);
+      if (++channel < adc_stream_channels) {
+        continue;
+      }
+      channel = 0;
+
+      if (++frames < window) {
+        continue;
+      }
+
+      /*
+       * Sequence number, status, frames count, then minimum, maximum and
+       * sum for each channel.
+       */
+      user_serial_transmit_character(sequence++);
+      user_serial_transmit_character(dropped ? 1 : 0);
+      user_serial_transmit_character(frames >> 8);
+      user_serial_transmit_character(frames);
+      for (channel = 0; channel < adc_stream_channels; channel++) {
+        user_serial_transmit_character(summaries[channel].minimum >> 8);
+        user_serial_transmit_character(summaries[channel].minimum);
+        user_serial_transmit_character(summaries[channel].maximum >> 8);
+        user_serial_transmit_character(summaries[channel].maximum);
+        binary_io_send_dword(summaries[channel].sum);
+        bp_adc_summary_reset(&summaries[channel]);
+      }
+      channel = 0;
+      frames = 0;
+      dropped = false;
+    }
+
+    adc_stream_tail = (adc_stream_tail + 1 == BINARY_IO_ADC_STREAM_BLOCKS)
+                          ? 0
+                          : adc_stream_tail + 1;
+  }
+
+  binary_io_adc_stream_stop();
+  user_serial_read_byte();
+  REPORT_IO_SUCCESS();
+}
+
 unsigned char getRXbyte(void) {
   // JTR Not required while (UART1RXRdy() == 0); //wait for a byte
   return user_serial_read_byte(); ///* JTR usb port; */ //grab it
@@ -559,13 +1403,14 @@ void PIC424Read(void);
  * 00001011 - Clock high
  * 00001100 - Data low
  * 00001101 - Data high
+ * 00001110 - Run program (see binwire_run_program)
  * 0001xxxx � Bulk transfer, send 1-16 bytes (0=1byte!)
  * 0010xxxx - Bulk clock ticks, send 1-16 ticks
  * 0011xxxx - Bulk bits, send 1-8 bits of the next byte (0=1bit!)
  * 0100wxyz � Configure peripherals, w=power, x=pullups, y=AUX, z=CS
  * 0101xxxx - Bulk read, read 1-16bytes (0=1byte!)
  * 0110000x � Set speed
- * 1000wxyz � Config, w=output type, x=3wire, y=lsb, z=n/a
+ * 1000wxyz � Config, w=output type, x=3wire, y=lsb, z=quiet writes
  ****************** BPv4 Specific Instructions *********************
  * 11110000 - Return SMPS output voltage
  * 11110001 - Stop SMPS operation
@@ -581,6 +1426,300 @@ enum {
     PIC614,
 };
 
+/**
+ * Flag indicating whether raw-wire commands that only acknowledge a write
+ * should stay silent.
+ */
+static bool binwire_quiet_writes;
+
+/**
+ * Acknowledges a raw-wire write command, unless quiet writes are enabled.
+ */
+static void binwire_acknowledge(void);
+
+/**
+ * Checks a raw-wire program and tells how many bytes it will produce.
+ *
+ * Results are stored in the same buffer the program is in, starting
+ * headroom bytes before the program itself.  A program is rejected if at
+ * any point its results would overwrite operation bytes that were not run
+ * yet.
+ *
+ * @param[in] program the program bytes.
+ * @param[in] length how many bytes are in the program.
+ * @param[in] wires the bus wires count, 2 or 3.
+ * @param[in] headroom how many buffer bytes are available before the
+ *                     program.
+ * @param[out] results how many result bytes the program will produce.
+ *
+ * @return true if the program is well formed and its results fit, false
+ *         otherwise.
+ */
+static bool binwire_check_program(const uint8_t *program, const uint16_t length,
+                                  const uint8_t wires, const uint16_t headroom,
+                                  uint16_t *results);
+
+/**
+ * Runs a raw-wire program, storing its results in the same buffer.
+ *
+ * A program is a sequence of the following operations, encoded like the
+ * equivalent raw-wire commands but with no acknowledgements:
+ *
+ * 00000010 - I2C style start bit
+ * 00000011 - I2C style stop bit
+ * 00000100 - CS low
+ * 00000101 - CS high
+ * 00000110 - Read byte (one result byte)
+ * 00000111 - Read bit (one result byte)
+ * 00001000 - Peek at input pin (one result byte)
+ * 00001001 - Clock tick
+ * 00001010 - Clock low
+ * 00001011 - Clock high
+ * 00001100 - Data low
+ * 00001101 - Data high
+ * 0001xxxx - Write the following 1-16 bytes (one result byte each in 3-wire
+ *            mode)
+ * 0010xxxx - 1-16 clock ticks
+ * 0011xxxx - Write 1-8 bits of the following byte
+ * 0101xxxx - Read 1-16 bytes (one result byte each)
+ *
+ * Results are written from the start of the given buffer, and the program
+ * sits at its end.  binwire_check_program makes sure each result only takes
+ * the place of a free byte or of an operation byte that was already run.
+ *
+ * @param[in,out] buffer the buffer holding the program, replaced by the
+ *                       results.
+ * @param[in] size how many bytes are in the buffer.
+ * @param[in] length how many bytes are in the program, already checked with
+ *                   binwire_check_program against size - length bytes of
+ *                   headroom.
+ * @param[in] wires the bus wires count, 2 or 3.
+ */
+static void binwire_run_program(uint8_t *buffer, const uint16_t size,
+                                const uint16_t length, const uint8_t wires);
+
+/**
+ * Reads a whole raw-wire program, runs it, and sends a single reply with all
+ * the results.
+ *
+ * @param[in] wires the bus wires count, 2 or 3.
+ */
+static void binwire_program(const uint8_t wires);
+
+void binwire_acknowledge(void) {
+  if (!binwire_quiet_writes) {
+    REPORT_IO_SUCCESS();
+  }
+}
+
+bool binwire_check_program(const uint8_t *program, const uint16_t length,
+                           const uint8_t wires, const uint16_t headroom,
+                           uint16_t *results) {
+  uint16_t offset;
+  uint8_t operation;
+  uint8_t count;
+
+  *results = 0;
+  offset = 0;
+  while (offset < length) {
+    operation = program[offset++];
+    count = (operation & 0x0F) + 1;
+
+    switch (operation >> 4) {
+    case 0b0000:
+      if ((operation < 0x02) || (operation > 0x0D)) {
+        return false;
+      }
+      if ((operation >= 0x06) && (operation <= 0x08)) {
+        (*results)++;
+      }
+      break;
+
+    case 0b0001:
+      offset += count;
+      if (wires == 3) {
+        *results += count;
+      }
+      break;
+
+    case 0b0010:
+      break;
+
+    case 0b0011:
+      if (count > 8) {
+        return false;
+      }
+      offset++;
+      break;
+
+    case 0b0101:
+      *results += count;
+      break;
+
+    default:
+      return false;
+    }
+
+    /* The results so far must not reach past the next operation byte. */
+    if (*results > (uint32_t)headroom + offset) {
+      return false;
+    }
+  }
+
+  return offset == length;
+}
+
+void binwire_run_program(uint8_t *buffer, const uint16_t size,
+                         const uint16_t length, const uint8_t wires) {
+  uint16_t offset;
+  uint16_t output;
+  uint8_t operation;
+  uint8_t count;
+  uint8_t value;
+
+  offset = size - length;
+  output = 0;
+  while (offset < size) {
+    operation = buffer[offset++];
+    count = (operation & 0x0F) + 1;
+
+    switch (operation >> 4) {
+    case 0b0000:
+      switch (operation) {
+      case 0x02:
+        bitbang_i2c_start();
+        break;
+
+      case 0x03:
+        bitbang_i2c_stop();
+        break;
+
+      case 0x04:
+      case 0x05:
+        bitbang_set_cs(operation & 1);
+        break;
+
+      case 0x06:
+        value = (wires == 2) ? bitbang_read_value()
+                             : bitbang_read_with_write(0xFF);
+        if (mode_configuration.little_endian == YES) {
+          value = bp_reverse_integer(value, mode_configuration.numbits);
+        }
+        buffer[output++] = value;
+        break;
+
+      case 0x07:
+        buffer[output++] = bitbang_read_bit();
+        break;
+
+      case 0x08:
+        buffer[output++] = bitbang_read_miso();
+        break;
+
+      case 0x09:
+        bitbang_advance_clock_ticks(1);
+        break;
+
+      case 0x0A:
+      case 0x0B:
+        bitbang_set_clk(operation & 1);
+        break;
+
+      case 0x0C:
+      case 0x0D:
+        bitbang_set_mosi(operation & 1);
+        break;
+
+      default:
+        break;
+      }
+      break;
+
+    case 0b0001:
+      while (count-- > 0) {
+        value = buffer[offset++];
+        if (mode_configuration.little_endian == YES) {
+          value = bp_reverse_integer(value, mode_configuration.numbits);
+        }
+        if (wires == 2) {
+          bitbang_write_value(value);
+        } else {
+          value = bitbang_read_with_write(value);
+          if (mode_configuration.little_endian == YES) {
+            value = bp_reverse_integer(value, mode_configuration.numbits);
+          }
+          buffer[output++] = value;
+        }
+      }
+      break;
+
+    case 0b0010:
+      bitbang_advance_clock_ticks(count);
+      break;
+
+    case 0b0011:
+      value = buffer[offset++];
+      while (count-- > 0) {
+        bitbang_write_bit(value & 0b10000000);
+        value <<= 1;
+      }
+      break;
+
+    case 0b0101:
+      while (count-- > 0) {
+        value = (wires == 2) ? bitbang_read_value()
+                             : bitbang_read_with_write(0xFF);
+        if (mode_configuration.little_endian == YES) {
+          value = bp_reverse_integer(value, mode_configuration.numbits);
+        }
+        buffer[output++] = value;
+      }
+      break;
+
+    default:
+      break;
+    }
+  }
+}
+
+void binwire_program(const uint8_t wires) {
+  uint8_t *program;
+  uint16_t length;
+  uint16_t results;
+  uint16_t index;
+
+  /* Program length, MSB first. */
+  length = user_serial_read_byte() << 8;
+  length |= user_serial_read_byte();
+
+  if ((length == 0) || (length > BP_TERMINAL_BUFFER_SIZE)) {
+    REPORT_IO_FAILURE();
+    return;
+  }
+
+  /*
+   * Read the whole program first, so it runs with no serial stalls.  It goes
+   * at the end of the buffer, leaving the space before it for the results.
+   */
+  program = bus_pirate_configuration.terminal_input +
+            (BP_TERMINAL_BUFFER_SIZE - length);
+  for (index = 0; index < length; index++) {
+    program[index] = user_serial_read_byte();
+  }
+
+  if (!binwire_check_program(program, length, wires,
+                             BP_TERMINAL_BUFFER_SIZE - length, &results)) {
+    REPORT_IO_FAILURE();
+    return;
+  }
+
+  binwire_run_program(bus_pirate_configuration.terminal_input,
+                      BP_TERMINAL_BUFFER_SIZE, length, wires);
+
+  REPORT_IO_SUCCESS();
+  bp_write_buffer(bus_pirate_configuration.terminal_input, results);
+}
+
 void binwire(void) {
     static unsigned char inByte, rawCommand, i, c, wires, picMode = PIC614;
     static unsigned int cmds, cmdw, cmdr, j;
@@ -589,6 +1728,7 @@ void binwire(void) {
     mode_configuration.little_endian = NO;
     mode_configuration.speed = 1;
     mode_configuration.numbits = 8;
+    binwire_quiet_writes = false;
     //startup in raw2wire mode
     wires = 2;
     //configure for raw3wire mode
@@ -623,19 +1763,19 @@ void binwire(void) {
                         break;
                     case 2://start bit
                         bitbang_i2c_start();
-                        user_serial_transmit_character(1);
+                        binwire_acknowledge();
                         break;
                     case 3://stop bit
                         bitbang_i2c_stop();
-                        user_serial_transmit_character(1);
+                        binwire_acknowledge();
                         break;
                     case 4: //cs low
                         bitbang_set_cs(0);
-                        user_serial_transmit_character(1);
+                        binwire_acknowledge();
                         break;
                     case 5://cs high
                         bitbang_set_cs(1);
-                        user_serial_transmit_character(1);
+                        binwire_acknowledge();
                         break;
                     case 6://read byte
                         if (wires == 2) {
@@ -656,23 +1796,26 @@ void binwire(void) {
                         break;
                     case 9://clock tick
                         bitbang_advance_clock_ticks(1);
-                        user_serial_transmit_character(1);
+                        binwire_acknowledge();
                         break;
                     case 10://clock low
                         bitbang_set_clk(0);
-                        user_serial_transmit_character(1);
+                        binwire_acknowledge();
                         break;
                     case 11://clock high
                         bitbang_set_clk(1);
-                        user_serial_transmit_character(1);
+                        binwire_acknowledge();
                         break;
                     case 12://data low
                         bitbang_set_mosi(0);
-                        user_serial_transmit_character(1);
+                        binwire_acknowledge();
                         break;
                     case 13://data high
                         bitbang_set_mosi(1);
-                        user_serial_transmit_character(1);
+                        binwire_acknowledge();
+                        break;
+                    case 14://run program
+                        binwire_program(wires);
                         break;
                     default:
                         user_serial_transmit_character(0);
@@ -683,7 +1826,7 @@ void binwire(void) {
             case 0b0001://get x+1 bytes
                 inByte &= (~0b11110000); //clear command portion
                 inByte++; //increment by 1, 0=1byte
-                user_serial_transmit_character(1); //send 1/OK
+                binwire_acknowledge(); //send 1/OK
 
                 for (i = 0; i < inByte; i++) {
                     c = user_serial_read_byte(); // /* JTR usb port; */;
@@ -692,7 +1835,7 @@ void binwire(void) {
                     }
                     if (wires == 2) {//2 wire, send 1
                         bitbang_write_value(c); //send byte
-                        user_serial_transmit_character(1);
+                        binwire_acknowledge();
                     } else { //3 wire, return read byte
                         c = bitbang_read_with_write(c); //send byte
                         if (mode_configuration.little_endian == YES) {
@@ -708,13 +1851,13 @@ void binwire(void) {
                 inByte &= (~0b11110000); //clear command portion
                 inByte++; //increment by 1, 0=1byte
                 bitbang_advance_clock_ticks(inByte);
-                user_serial_transmit_character(1); //send 1/OK
+                binwire_acknowledge(); //send 1/OK
                 break;
 
             case 0b0011: //# 0011xxxx - Bulk bits, send 1-8 bits of the next byte (0=1bit!)
                 inByte &= (~0b11110000); //clear command portion
                 inByte++; //increment by 1, 0=1byte
-                user_serial_transmit_character(1); //send 1/OK
+                binwire_acknowledge(); //send 1/OK
 
                 rawCommand = user_serial_read_byte(); //  //get byte, reuse rawCommand variable
                 for (i = 0; i < inByte; i++) {
@@ -725,7 +1868,7 @@ void binwire(void) {
                     }
                     rawCommand = rawCommand << 1; //pop the MSB off
                 }
-                user_serial_transmit_character(1);
+                binwire_acknowledge();
                 break;
 
             case 0b1010:// PIC commands
@@ -931,7 +2074,7 @@ void binwire(void) {
                 mode_configuration.little_endian = NO;
                 if (inByte & 0b10) mode_configuration.little_endian = YES; //lsb/msb, bit order
 
-                //if(inByte&0b1) //bit unused
+                binwire_quiet_writes = (inByte & 0b1) != 0; //no acks for writes
 
                 bitbang_setup(wires, mode_configuration.speed); //setup the bitbang library, must be done before calling bbCS below
                 bitbang_set_cs(1); //takes care of custom HiZ settings too
@@ -68,6 +68,62 @@ static const bitbang_delays_t BITBANG_DELAYS[] = {
     {.settle = BB_100KHZSPEED_SETTLE, .clock = BB_100KHZSPEED_CLOCK},
     {.settle = BB_MAXSPEED_SETTLE, .clock = BB_MAXSPEED_CLOCK}};
 
+/**
+ * Sets the given pins HIGH, either driving them or releasing them if the bus
+ * is in open drain mode.
+ */
+#define BITBANG_PINS_HIGH(pins, open_drain)                                    \
+  do {                                                                         \
+    if (open_drain) {                                                          \
+      IODIR |= (pins);                                                         \
+    } else {                                                                   \
+      IOLAT |= (pins);                                                         \
+      IODIR &= ~(pins);                                                        \
+    }                                                                          \
+  } while (0)
+
+/**
+ * Drives the given pins LOW.
+ */
+#define BITBANG_PINS_LOW(pins)                                                 \
+  do {                                                                         \
+    IOLAT &= ~(pins);                                                          \
+    IODIR &= ~(pins);                                                          \
+  } while (0)
+
+/**
+ * Waits for the given amount of microseconds, if any.
+ *
+ * With a constant argument this either compiles to a fixed cycles count or
+ * to nothing at all.
+ */
+#define BITBANG_DELAY(microseconds)                                            \
+  do {                                                                         \
+    if ((microseconds) > 0) {                                                  \
+      bp_delay_us(microseconds);                                               \
+    }                                                                          \
+  } while (0)
+
+/**
+ * Switches the given pin to input and reads it, like bitbang_read_pin().
+ */
+#define BITBANG_READ_PIN(pin)                                                  \
+  (IODIR |= (pin), Nop(), Nop(), Nop(), (IOPOR & (pin)) != 0)
+
+/**
+ * Bus transfer loops specialised for a given bus speed.
+ */
+typedef struct {
+  /** @see bitbang_read_with_write */
+  uint16_t (*read_with_write)(const uint16_t value);
+
+  /** @see bitbang_write_value */
+  void (*write_value)(const uint16_t value);
+
+  /** @see bitbang_read_value */
+  uint16_t (*read_value)(void);
+} bitbang_kernels_t;
+
 /**
  * Which pin to use for bus reads.
  */
@@ -79,11 +135,159 @@ static uint16_t miso_pin;
  */
 static const bitbang_delays_t *delay_profile;
 
+/**
+ * Generic read/write loop, to be inlined with constant delays.
+ *
+ * The open drain setting and the bits count are read once per call rather
+ * than once per bit.
+ *
+ * @param[in] value the value to write on the bus.
+ * @param[in] settle the MOSI settle delay, in microseconds.
+ * @param[in] clock the CLK delay, in microseconds.
+ *
+ * @return the value read from the bus.
+ */
+static inline __attribute__((always_inline)) uint16_t
+bitbang_read_with_write_kernel(const uint16_t value, const uint16_t settle,
+                               const uint16_t clock) {
+  uint16_t bit_index;
+  uint16_t input;
+  bool open_drain;
+
+  open_drain = mode_configuration.high_impedance != OFF;
+  input = 0;
+  for (bit_index = 1 << (mode_configuration.numbits - 1); bit_index != 0;
+       bit_index >>= 1) {
+    if (value & bit_index) {
+      BITBANG_PINS_HIGH(MOSI, open_drain);
+    } else {
+      BITBANG_PINS_LOW(MOSI);
+    }
+    BITBANG_DELAY(settle);
+    BITBANG_PINS_HIGH(CLK, open_drain);
+    BITBANG_DELAY(clock);
+    input = (input << 1) | BITBANG_READ_PIN(MISO);
+    BITBANG_PINS_LOW(CLK);
+    BITBANG_DELAY(clock);
+  }
+
+  return input;
+}
+
+/**
+ * Generic write loop, to be inlined with constant delays.
+ *
+ * @param[in] value the value to write on the bus.
+ * @param[in] settle the MOSI settle delay, in microseconds.
+ * @param[in] clock the CLK delay, in microseconds.
+ */
+static inline __attribute__((always_inline)) void
+bitbang_write_value_kernel(const uint16_t value, const uint16_t settle,
+                           const uint16_t clock) {
+  uint16_t bit_index;
+  bool open_drain;
+
+  open_drain = mode_configuration.high_impedance != OFF;
+  for (bit_index = 1 << (mode_configuration.numbits - 1); bit_index != 0;
+       bit_index >>= 1) {
+    if (value & bit_index) {
+      BITBANG_PINS_HIGH(MOSI, open_drain);
+    } else {
+      BITBANG_PINS_LOW(MOSI);
+    }
+    BITBANG_DELAY(settle);
+    BITBANG_PINS_HIGH(CLK, open_drain);
+    BITBANG_DELAY(clock);
+    BITBANG_PINS_LOW(CLK);
+    BITBANG_DELAY(clock);
+  }
+}
+
+/**
+ * Generic read loop, to be inlined with constant delays.
+ *
+ * @param[in] clock the CLK delay, in microseconds.
+ *
+ * @return the value read from the bus.
+ */
+static inline __attribute__((always_inline)) uint16_t
+bitbang_read_value_kernel(const uint16_t clock) {
+  uint16_t bit_index;
+  uint16_t value;
+  bool open_drain;
+
+  /* Setup for input. */
+  bitbang_read_pin(MOSI);
+
+  open_drain = mode_configuration.high_impedance != OFF;
+  value = 0;
+  for (bit_index = 1 << (mode_configuration.numbits - 1); bit_index != 0;
+       bit_index >>= 1) {
+    BITBANG_PINS_HIGH(CLK, open_drain);
+    BITBANG_DELAY(clock);
+    value = (value << 1) | BITBANG_READ_PIN(MOSI);
+    BITBANG_PINS_LOW(CLK);
+    BITBANG_DELAY(clock);
+  }
+
+  return value;
+}
+
+/**
+ * Instantiates the transfer loops for the given speed, using the
+ * BB_<speed>_SETTLE and BB_<speed>_CLOCK delays.
+ */
+#define BITBANG_DEFINE_KERNELS(speed)                                          \
+  static uint16_t bitbang_read_with_write_##speed(const uint16_t value) {      \
+    return bitbang_read_with_write_kernel(value, BB_##speed##_SETTLE,          \
+                                          BB_##speed##_CLOCK);                 \
+  }                                                                            \
+                                                                               \
+  static void bitbang_write_value_##speed(const uint16_t value) {              \
+    bitbang_write_value_kernel(value, BB_##speed##_SETTLE,                     \
+                               BB_##speed##_CLOCK);                            \
+  }                                                                            \
+                                                                               \
+  static uint16_t bitbang_read_value_##speed(void) {                           \
+    return bitbang_read_value_kernel(BB_##speed##_CLOCK);                      \
+  }
+
+BITBANG_DEFINE_KERNELS(5KHZSPEED)
+BITBANG_DEFINE_KERNELS(50KHZSPEED)
+BITBANG_DEFINE_KERNELS(100KHZSPEED)
+BITBANG_DEFINE_KERNELS(MAXSPEED)
+
+/**
+ * Transfer loops for each bus speed, in bp_bitbang_speed_t order.
+ *
+ * @see bp_bitbang_speed_t
+ */
+static const bitbang_kernels_t BITBANG_KERNELS[] = {
+    {.read_with_write = bitbang_read_with_write_5KHZSPEED,
+     .write_value = bitbang_write_value_5KHZSPEED,
+     .read_value = bitbang_read_value_5KHZSPEED},
+    {.read_with_write = bitbang_read_with_write_50KHZSPEED,
+     .write_value = bitbang_write_value_50KHZSPEED,
+     .read_value = bitbang_read_value_50KHZSPEED},
+    {.read_with_write = bitbang_read_with_write_100KHZSPEED,
+     .write_value = bitbang_write_value_100KHZSPEED,
+     .read_value = bitbang_read_value_100KHZSPEED},
+    {.read_with_write = bitbang_read_with_write_MAXSPEED,
+     .write_value = bitbang_write_value_MAXSPEED,
+     .read_value = bitbang_read_value_MAXSPEED}};
+
+/**
+ * The transfer loops to use, selected along with the delay profile.
+ */
+static const bitbang_kernels_t *kernels;
+
 void bitbang_setup(unsigned char bitbang_pins, const bp_bitbang_speed_t speed) {
+  size_t index;
+
+  index = speed > DELAY_PROFILES_MAX_INDEX ? DELAY_PROFILES_MAX_INDEX : speed;
   miso_pin = (bitbang_pins == 3) ? MISO : MOSI;
-  delay_profile = &BITBANG_DELAYS[speed > DELAY_PROFILES_MAX_INDEX
-                                      ? DELAY_PROFILES_MAX_INDEX
-                                      : speed];
+  delay_profile = &BITBANG_DELAYS[index];
+  kernels = &BITBANG_KERNELS[index];
 }
 
 bool bitbang_i2c_start(void) {
@@ -123,56 +327,12 @@ void bitbang_i2c_stop(void) {
 }
 
 uint16_t bitbang_read_with_write(const uint16_t value) {
-  size_t count;
-  uint16_t temporary;
-  uint16_t bit_index;
-  uint16_t input;
-
-  bit_index = 1 << (mode_configuration.numbits - 1);
-  temporary = value;
-  input = 0;
-  for (count = 0; count < mode_configuration.numbits; count++) {
-    bitbang_set_pins(temporary & bit_index, MOSI, delay_profile->settle);
-    bitbang_set_pins_high(CLK, delay_profile->clock);
-    input = (input << 1) | bitbang_read_pin(MISO);
-    temporary <<= 1;
-    bitbang_set_pins_low(CLK, delay_profile->clock);
-  }
-
-  return input;
+  return kernels->read_with_write(value);
 }
 
-void bitbang_write_value(const uint16_t value) {
-  uint16_t temporary;
-  uint16_t bit_index;
-  size_t count;
-
-  bit_index = 1 << (mode_configuration.numbits - 1);
-  temporary = value;
-  for (count = 0; count < mode_configuration.numbits; count++) {
-    bitbang_set_pins(temporary & bit_index, MOSI, delay_profile->settle);
-    bitbang_set_pins_high(CLK, delay_profile->clock);
-    bitbang_set_pins_low(CLK, delay_profile->clock);
-    temporary <<= 1;
-  }
-}
+void bitbang_write_value(const uint16_t value) { kernels->write_value(value); }
 
-uint16_t bitbang_read_value(void) {
-  size_t count;
-  uint16_t value;
-
-  /* Setup for input. */
-  bitbang_read_pin(MOSI);
-  value = 0;
-
-  for (count = 0; count < mode_configuration.numbits; count++) {
-    bitbang_set_pins_high(CLK, delay_profile->clock);
-    value = (value << 1) | bitbang_read_pin(MOSI);
-    bitbang_set_pins_low(CLK, delay_profile->clock);
-  }
-
-  return value;
-}
+uint16_t bitbang_read_value(void) { return kernels->read_value(); }
 
 bool bitbang_read_bit(void) {
   bool bit_value;
@@ -375,6 +375,23 @@
 
 #endif /* BP_ENABLE_1WIRE_SUPPORT */
 
+/* SUMP module configuration definitions. */
+
+#ifdef BP_ENABLE_SUMP_SUPPORT
+
+/**
+ * Store two samples per byte in SUMP captures, doubling the capture depth.
+ *
+ * Only four probes fit in a nibble, so the AUX probe is not captured when
+ * this is enabled.  Streaming captures are not affected.
+ *
+ * Disabled by default to keep all five probes available.
+ */
+
+#undef BP_SUMP_PACKED_SAMPLES
+
+#endif /* BP_ENABLE_SUMP_SUPPORT */
+
 /* I2C module configuration definitions. */
 
 #ifdef BP_ENABLE_I2C_SUPPORT
@@ -552,4 +569,15 @@
  */
 #define BP_TERMINAL_BUFFER_SIZE 4096
 
+#ifdef BUSPIRATEV3
+
+/**
+ * How big the interrupt-driven user serial transmission queue is, in bytes.
+ *
+ * @warning This must be set to a power of two, ie. 256, 128, 64, 32, etc.
+ */
+#define BP_USER_SERIAL_TX_QUEUE_SIZE 256
+
+#endif /* BUSPIRATEV3 */
+
 #endif /* !BP_CONFIGURATION_H */
\ No newline at end of file
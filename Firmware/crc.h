@@ -0,0 +1,94 @@
+/*
+ * This file is part of the Bus Pirate project
+ * (http://code.google.com/p/the-bus-pirate/).
+ *
+ * Written and maintained by the Bus Pirate project.
+ *
+ * To the extent possible under law, the project has waived all copyright and
+ * related or neighboring rights to Bus Pirate.  This work is published from
+ * United States.
+ *
+ * For details see: http://creativecommons.org/publicdomain/zero/1.0/
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.
+ */
+
+/**
+ * @file crc.h
+ *
+ * @brief Table-driven CRC routines shared by protocol handlers.
+ *
+ * All routines take the CRC value to start from, so that data can be fed in
+ * chunks by passing the result of the previous call.
+ *
+ * The CRC16 and CRC32 routines are only built when BP_CRC_WIDE_ROUTINES is
+ * defined.  No firmware feature uses them yet, so they are left out of the
+ * firmware to save flash; the host tests build them in.
+ */
+
+#ifndef BP_CRC_H
+#define BP_CRC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Updates a CRC8-Maxim (Dallas 1-Wire) value with the given byte.
+ *
+ * Polynomial x^8 + x^5 + x^4 + 1, reflected, used for 1-Wire ROM numbers and
+ * scratchpads.
+ *
+ * @param[in] crc the CRC value to update, 0 to start a new computation.
+ * @param[in] value the byte to add to the CRC.
+ *
+ * @return the updated CRC value.
+ */
+uint8_t crc8_maxim_update(const uint8_t crc, const uint8_t value);
+
+/**
+ * @brief Computes the CRC8-Maxim value of the given buffer.
+ *
+ * @param[in] crc the CRC value to start from, 0 to start a new computation.
+ * @param[in] buffer the data to compute the CRC of.
+ * @param[in] length how many bytes to read from the buffer.
+ *
+ * @return the updated CRC value.  Running a buffer followed by its own CRC
+ *         byte yields zero.
+ */
+uint8_t crc8_maxim(uint8_t crc, const uint8_t *buffer, size_t length);
+
+#ifdef BP_CRC_WIDE_ROUTINES
+
+/**
+ * @brief Computes the CRC16-IBM value of the given buffer.
+ *
+ * Polynomial x^16 + x^15 + x^2 + 1, reflected, used for 1-Wire memory pages
+ * (e.g. DS2431).  1-Wire devices transmit the inverted CRC value.
+ *
+ * @param[in] crc the CRC value to start from, 0 to start a new computation.
+ * @param[in] buffer the data to compute the CRC of.
+ * @param[in] length how many bytes to read from the buffer.
+ *
+ * @return the updated CRC value.
+ */
+uint16_t crc16_ibm(uint16_t crc, const uint8_t *buffer, size_t length);
+
+/**
+ * @brief Computes the CRC32 (IEEE 802.3) value of the given buffer.
+ *
+ * The initial and final inversions are handled internally, so the result of
+ * a call can be passed as the starting value of the next one.
+ *
+ * @param[in] crc the CRC value to start from, 0 to start a new computation.
+ * @param[in] buffer the data to compute the CRC of.
+ * @param[in] length how many bytes to read from the buffer.
+ *
+ * @return the updated CRC value.
+ */
+uint32_t crc32(uint32_t crc, const uint8_t *buffer, size_t length);
+
+#endif /* BP_CRC_WIDE_ROUTINES */
+
+#endif /* !BP_CRC_H */
@@ -59,6 +59,8 @@ BYTE LineStateUpdated = 0;
 BYTE cdc_timeout_count = 0;
 BYTE ZLPpending = 0;
 BYTE lock = 0;
+BYTE cdc_flush_policy = CDC_FLUSH_REPLY;
+BYTE cdc_flush_policy_override = CDC_FLUSH_AUTOMATIC;
 
 BDentry *CDC_Outbdp, *CDC_Inbdp;
 BYTE CDCFunctionError;
@@ -314,10 +316,42 @@ void CDC_Flush_In_Now(void) {
     }
 }
 
+/******************************************************************************/
+// Returns the flush policy in effect, the override if one is set or else
+// the one selected by the current mode.
+
+static BYTE cdc_active_flush_policy(void) {
+    if (cdc_flush_policy_override != CDC_FLUSH_AUTOMATIC) {
+        return cdc_flush_policy_override;
+    }
+    return cdc_flush_policy;
+}
+
+/******************************************************************************/
+// Sends whatever is waiting in the current IN buffer, or the ZLP owed after a
+// full packet. If wait is zero nothing is sent while the endpoint is busy.
+
+static void cdc_flush_pending(BYTE wait) {
+    if ((cdc_In_len == 0) && !ZLPpending) {
+        return;
+    }
+    if (!wait && !getInReady()) {
+        return;
+    }
+    lock = 1; // Stops CDCFlushOnTimeout() from sending per chance it is on interrupts.
+    putda_cdc(cdc_In_len); // Sends a ZLP if the buffer is empty.
+    cdc_In_len = 0;
+    ZLPpending = 0;
+    cdc_timeout_count = 0;
+    lock = 0;
+}
+
 /******************************************************************************/
 void CDCFlushOnTimeout(void) {
+    BYTE timeout;
 
-    if (cdc_timeout_count >= CDC_FLUSH_MS) { // For timeout value see: cdc_config.h -> [hardware] -> CDC_FLUSH_MS
+    timeout = (cdc_active_flush_policy() == CDC_FLUSH_STREAM) ? CDC_STREAM_FLUSH_MS : CDC_FLUSH_MS;
+    if (cdc_timeout_count >= timeout) { // For timeout value see: cdc_config.h -> [hardware] -> CDC_FLUSH_MS
 
         if (cdc_In_len > 0) {
             if ((lock == 0) && getInReady()) {
@@ -330,7 +364,7 @@ void CDCFlushOnTimeout(void) {
                 cdc_In_len = 0;
                 cdc_timeout_count = 0;
             }
-        } else if (ZLPpending) {
+        } else if (ZLPpending && (lock == 0)) {
             putda_cdc(0);
             ZLPpending = 0;
             cdc_timeout_count = 0;
@@ -340,9 +374,51 @@ void CDCFlushOnTimeout(void) {
     }
 }
 
+/******************************************************************************/
+// To be called when the host has nothing more for us: the reply to its last
+// command is complete, so under CDC_FLUSH_REPLY it is sent right away rather
+// than on the next timeout. Returns without waiting if the endpoint is busy,
+// the caller is expected to poll again.
+
+void CDC_Flush_In_Idle(void) {
+    if (cdc_active_flush_policy() == CDC_FLUSH_REPLY) {
+        cdc_flush_pending(0);
+    }
+}
+
+/******************************************************************************/
+// Selects the flush policy suited to the current mode: CDC_FLUSH_REPLY for
+// command/response traffic, CDC_FLUSH_STREAM while streaming data out.
+
+void cdc_set_flush_policy(BYTE policy) {
+    cdc_flush_policy = policy;
+}
+
+/******************************************************************************/
+// Forces a flush policy regardless of the mode, CDC_FLUSH_AUTOMATIC gives
+// control back to the modes.
+
+void cdc_override_flush_policy(BYTE policy) {
+    cdc_flush_policy_override = policy;
+}
+
+/******************************************************************************/
+// Restarts the flush timeout after data was queued. Under CDC_FLUSH_STREAM the
+// timeout runs from the first byte of a packet, so a steady trickle of writes
+// cannot hold a partial packet longer than CDC_STREAM_FLUSH_MS.
+
+static void cdc_restart_flush_timeout(BYTE new_packet) {
+    if (new_packet || (cdc_active_flush_policy() != CDC_FLUSH_STREAM)) {
+        cdc_timeout_count = 0;
+    }
+}
+
 /******************************************************************************/
 void putc_cdc(BYTE c) {
+    BYTE new_packet;
+
     lock = 1; // Stops CDCFlushOnTimeout() from sending per chance it is on interrupts.
+    new_packet = (cdc_In_len == 0);
     *InPtr = c;
     InPtr++;
     cdc_In_len++;
@@ -351,30 +427,108 @@ void putc_cdc(BYTE c) {
         putda_cdc(cdc_In_len); // This will stall tranfers if both buffers are full then return when a buffer is available.
         cdc_In_len = 0;
         ZLPpending = 1; // timeout handled in the SOF handler below.
+        new_packet = 1;
     }
     lock = 0;
-    cdc_timeout_count = 0; //setup timer to throw data if the buffer doesn't fill
+    cdc_restart_flush_timeout(new_packet); //setup timer to throw data if the buffer doesn't fill
 }
 
 /******************************************************************************/
-// Waits for a byte to be available and returns that byte as a
-// function return value. The byte is removed from the CDC OUT queue.
-// No return count is required as this function always returns one byte.
+// Sends count bytes starting at *buffer to the host in as few packets as
+// possible. Each IN buffer is filled straight from the source and handed to
+// the endpoint as soon as it is full, so the next one is being filled while
+// the previous one is on the wire. Like with putc_cdc(), a partial packet left
+// once the data runs out stays in the IN buffer, so back to back writes share
+// packets; it is sent as the active flush policy dictates.
+
+void put_buffer_cdc(const BYTE * buffer, unsigned int count) {
+    BYTE chunk;
+    BYTE new_packet;
+
+    if (count == 0) {
+        return;
+    }
 
-BYTE getc_cdc(void) { // Must be used only in double buffer mode.
-    BYTE c = 0;
+    lock = 1; // Stops CDCFlushOnTimeout() from sending per chance it is on interrupts.
+    new_packet = (cdc_In_len == 0);
+    ZLPpending = 0;
+    while (count > 0) {
+        chunk = CDC_BUFFER_SIZE - cdc_In_len;
+        if (count < chunk) {
+            chunk = count;
+        }
+        memcpy(InPtr, buffer, chunk);
+        InPtr += chunk;
+        buffer += chunk;
+        count -= chunk;
+        cdc_In_len += chunk;
+        if (cdc_In_len == CDC_BUFFER_SIZE) {
+            putda_cdc(cdc_In_len); // Blocks only while both buffers are owned by the SIE.
+            cdc_In_len = 0;
+            ZLPpending = 1; // timeout handled in the SOF handler.
+            new_packet = 1;
+        }
+    }
+    lock = 0;
+    cdc_restart_flush_timeout(new_packet); //setup timer to throw data if the buffer doesn't fill
+}
+
+/******************************************************************************/
+// Makes sure the CDC OUT queue holds at least one byte, waiting for the host
+// if it does not.
 
+static void cdc_wait_out_data(void) {
     if (cdc_Out_len == 0) {
+        // About to wait on the host, there is no point in holding back what
+        // it is presumably waiting for.
+        if ((cdc_active_flush_policy() != CDC_FLUSH_TIMEOUT) && !getOutReady()) {
+            cdc_flush_pending(1);
+        }
         do {
             cdc_Out_len = getda_cdc();
         } while (cdc_Out_len == 0); // Skip any ZLP
     }
+}
+
+/******************************************************************************/
+// Waits for a byte to be available and returns that byte as a
+// function return value. The byte is removed from the CDC OUT queue.
+// No return count is required as this function always returns one byte.
+
+BYTE getc_cdc(void) { // Must be used only in double buffer mode.
+    BYTE c = 0;
+
+    cdc_wait_out_data();
     c = *OutPtr;
     OutPtr++;
     cdc_Out_len--;
     return c;
 }
 
+/******************************************************************************/
+// Waits for at least one byte to be available and returns how many unread
+// bytes the current CDC OUT buffer holds, with *span pointing to the first
+// of them. Nothing is removed from the queue until consume_cdc() is called,
+// so the caller can work on the packet in place. The endpoint is already
+// armed with the other buffer meanwhile, so the host can send the next
+// packet while this one is being processed.
+
+BYTE getspan_cdc(BYTE ** span) { // Must be used only in double buffer mode.
+
+    cdc_wait_out_data();
+    *span = OutPtr;
+    return cdc_Out_len;
+}
+
+/******************************************************************************/
+// Removes count bytes, at most what getspan_cdc() returned, from the CDC OUT
+// queue.
+
+void consume_cdc(BYTE count) {
+    OutPtr += count;
+    cdc_Out_len -= count;
+}
+
 /******************************************************************************/
 // Checks to see if there is a byte available in the CDC buffer.
 // If so, it returns that byte at the dereferenced pointer *C
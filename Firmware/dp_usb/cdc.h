@@ -29,14 +29,26 @@ BYTE getda_cdc(void);
 BYTE putda_cdc(BYTE count);
 void SendZLP(void);
 BYTE getc_cdc(void);
+BYTE getspan_cdc(BYTE ** span);
+void consume_cdc(BYTE count);
 void putc_cdc(BYTE c);
+void put_buffer_cdc(const BYTE * buffer, unsigned int count);
 void CDC_Flush_In_Now(void);
 void CDCFlushOnTimeout(void);
+void CDC_Flush_In_Idle(void);
+void cdc_set_flush_policy(BYTE policy);
+void cdc_override_flush_policy(BYTE policy);
 BYTE poll_getc_cdc(BYTE * c);
 BYTE peek_getc_cdc(BYTE * c);
 void initCDC(void);
 
 
+// CDC In flush policies, see cdc_set_flush_policy()
+#define CDC_FLUSH_AUTOMATIC 0 // Override only: use whatever the mode asked for.
+#define CDC_FLUSH_TIMEOUT 1   // Flush after CDC_FLUSH_MS only.
+#define CDC_FLUSH_REPLY 2     // Also flush as soon as nothing is left to read.
+#define CDC_FLUSH_STREAM 3    // Hold partial packets for up to CDC_STREAM_FLUSH_MS.
+
 struct _cdc_ControlLineState {
     int DTR : 1;
     int RTS : 1;
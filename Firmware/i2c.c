@@ -806,6 +806,7 @@ void i2c_sniffer(bool interactive_mode) {
 
   /* Setup UART ringbuffer. */
   user_serial_ringbuffer_setup();
+  user_serial_set_flush_policy(USER_SERIAL_FLUSH_WHEN_FULL);
 
   SDA_TRIS = INPUT;
   SCL_TRIS = INPUT;
@@ -897,6 +898,9 @@ void i2c_sniffer(bool interactive_mode) {
   BP_MOSI_CN = OFF;
   BP_CLK_CN = OFF;
 
+  user_serial_ringbuffer_release();
+  user_serial_set_flush_policy(USER_SERIAL_FLUSH_ON_REPLY);
+
   if (interactive_mode) {
     bpBR;
   }
@@ -932,6 +936,9 @@ rawI2C mode:
 void binary_io_enter_i2c_mode(void) {
   static unsigned char inByte, rawCommand, i;
   unsigned int j, fw, fr;
+  const uint8_t *span;
+  uint8_t count;
+  bool nack;
 
   SDA_TRIS = INPUT;
   SCL_TRIS = INPUT;
@@ -1004,23 +1011,29 @@ void binary_io_enter_i2c_mode(void) {
           break;
         }
 
-        // get bytes
-        for (j = 0; j < fw; j++) {
-          bus_pirate_configuration.terminal_input[j] = user_serial_read_byte();
-        }
-
         // start
         bitbang_i2c_start();
 
-        for (j = 0; j < fw; j++) {
-          // get ACK
-          // if no ack, goto error
-          bitbang_write_value(
-              bus_pirate_configuration.terminal_input[j]); // send byte
-          if (bitbang_read_bit() == 1)
-            goto I2C_write_read_error;
+        // send bytes straight from the serial input, after a NACK keep
+        // consuming them so the next command is read in sync
+        nack = false;
+        while (fw > 0) {
+          count = user_serial_peek_span(&span);
+          if (count > fw) {
+            count = fw;
+          }
+          for (j = 0; !nack && (j < count); j++) {
+            bitbang_write_value(span[j]); // send byte
+            nack = bitbang_read_bit() == 1; // get ACK
+          }
+          user_serial_consume_span(count);
+          fw -= count;
         }
 
+        // if no ack, goto error
+        if (nack)
+          goto I2C_write_read_error;
+
         fw = fr - 1;
         for (j = 0; j < fr; j++) { // read bulk bytes from SPI
           // send ack
@@ -1038,9 +1051,8 @@ void binary_io_enter_i2c_mode(void) {
 
         REPORT_IO_SUCCESS();
 
-        for (j = 0; j < fr; j++) { // send the read buffer contents over serial
-          user_serial_transmit_character(bus_pirate_configuration.terminal_input[j]);
-        }
+        // send the read buffer contents over serial
+        bp_write_buffer(bus_pirate_configuration.terminal_input, fr);
         break; // 00001001 xxxxxxxx
 
       case 9: // extended AUX command
@@ -42,7 +42,7 @@ static void initialize_board(void);
  * Internal terminal buffer area.
  */
 static uint8_t bp_buffer[BP_TERMINAL_BUFFER_SIZE]
-    __attribute__((section(".bss.end")));
+    __attribute__((section(".bss.end"), aligned(2)));
 
 /**
  * Global configuration data holder.
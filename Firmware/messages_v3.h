@@ -379,10 +379,18 @@ void MSG_1WIRE_NO_DEVICE_str(void);
 #define MSG_1WIRE_NO_DEVICE bp_message_write_line(__builtin_tbladdress(MSG_1WIRE_NO_DEVICE_str))
 void MSG_1WIRE_NO_DEVICE_DETECTED_str(void);
 #define MSG_1WIRE_NO_DEVICE_DETECTED bp_message_write_buffer(__builtin_tbladdress(MSG_1WIRE_NO_DEVICE_DETECTED_str))
+void MSG_1WIRE_OVERDRIVE_MATCH_ROM_MACRO_NAME_str(void);
+#define MSG_1WIRE_OVERDRIVE_MATCH_ROM_MACRO_NAME bp_message_write_line(__builtin_tbladdress(MSG_1WIRE_OVERDRIVE_MATCH_ROM_MACRO_NAME_str))
+void MSG_1WIRE_OVERDRIVE_SKIP_ROM_MACRO_NAME_str(void);
+#define MSG_1WIRE_OVERDRIVE_SKIP_ROM_MACRO_NAME bp_message_write_line(__builtin_tbladdress(MSG_1WIRE_OVERDRIVE_SKIP_ROM_MACRO_NAME_str))
 void MSG_1WIRE_PINS_STATE_str(void);
 #define MSG_1WIRE_PINS_STATE bp_message_write_line(__builtin_tbladdress(MSG_1WIRE_PINS_STATE_str))
 void MSG_1WIRE_READ_ROM_MACRO_NAME_str(void);
 #define MSG_1WIRE_READ_ROM_MACRO_NAME bp_message_write_buffer(__builtin_tbladdress(MSG_1WIRE_READ_ROM_MACRO_NAME_str))
+void MSG_1WIRE_ROSTER_CONVERT_MACRO_NAME_str(void);
+#define MSG_1WIRE_ROSTER_CONVERT_MACRO_NAME bp_message_write_line(__builtin_tbladdress(MSG_1WIRE_ROSTER_CONVERT_MACRO_NAME_str))
+void MSG_1WIRE_SCRATCHPAD_CRC_ERROR_str(void);
+#define MSG_1WIRE_SCRATCHPAD_CRC_ERROR bp_message_write_line(__builtin_tbladdress(MSG_1WIRE_SCRATCHPAD_CRC_ERROR_str))
 void MSG_1WIRE_SEARCH_MACRO_NAME_str(void);
 #define MSG_1WIRE_SEARCH_MACRO_NAME bp_message_write_line(__builtin_tbladdress(MSG_1WIRE_SEARCH_MACRO_NAME_str))
 void MSG_1WIRE_SKIP_ROM_MACRO_NAME_str(void);
@@ -511,6 +519,8 @@ void MSG_RAW2WIRE_MACRO_MENU_str(void);
 #define MSG_RAW2WIRE_MACRO_MENU bp_message_write_buffer(__builtin_tbladdress(MSG_RAW2WIRE_MACRO_MENU_str))
 void MSG_RAW2WIRE_MODE_HEADER_str(void);
 #define MSG_RAW2WIRE_MODE_HEADER bp_message_write_buffer(__builtin_tbladdress(MSG_RAW2WIRE_MODE_HEADER_str))
+void MSG_RAW3WIRE_HARDWARE_SPI_PROMPT_str(void);
+#define MSG_RAW3WIRE_HARDWARE_SPI_PROMPT bp_message_write_line(__builtin_tbladdress(MSG_RAW3WIRE_HARDWARE_SPI_PROMPT_str))
 void MSG_RAW3WIRE_MODE_HEADER_str(void);
 #define MSG_RAW3WIRE_MODE_HEADER bp_message_write_buffer(__builtin_tbladdress(MSG_RAW3WIRE_MODE_HEADER_str))
 void MSG_RAW_BRG_VALUE_INPUT_str(void);
@@ -545,6 +555,8 @@ void MSG_SPI_SAMPLE_PROMPT_str(void);
 #define MSG_SPI_SAMPLE_PROMPT bp_message_write_line(__builtin_tbladdress(MSG_SPI_SAMPLE_PROMPT_str))
 void MSG_SPI_SPEED_PROMPT_str(void);
 #define MSG_SPI_SPEED_PROMPT bp_message_write_line(__builtin_tbladdress(MSG_SPI_SPEED_PROMPT_str))
+void MSG_UART_BRG_LOCKED_str(void);
+#define MSG_UART_BRG_LOCKED bp_message_write_buffer(__builtin_tbladdress(MSG_UART_BRG_LOCKED_str))
 void MSG_UART_MODE_IDENTIFIER_str(void);
 #define MSG_UART_MODE_IDENTIFIER bp_message_write_buffer(__builtin_tbladdress(MSG_UART_MODE_IDENTIFIER_str))
 void MSG_UART_PINS_STATE_str(void);
@@ -734,7 +734,7 @@ _BPMSG1202_str:
 	.section .text.BPMSG1203, code
 	.global _BPMSG1203_str
 _BPMSG1203_str:
-	.pasciz " 0.Macro menu\r\n 1.Transparent bridge\r\n 2.Live monitor\r\n 3.Bridge with flow control\n\r 4.Auto Baud Detection (Activity Needed)"
+	.pasciz " 0.Macro menu\r\n 1.Transparent bridge\r\n 2.Live monitor\r\n 3.Bridge with flow control\n\r 4.Auto Baud Detection (Activity Needed)\r\n 5.Auto Baud Lock (Activity Needed)"
 
 	; BPMSG1204
 	.section .text.BPMSG1204, code
@@ -1088,7 +1088,7 @@ _HLP1011_str:
 	.section .text.HLP1012, code
 	.global _HLP1012_str
 _HLP1012_str:
-	.pasciz "f\tMeasure frequency\t\tr\tRead"
+	.pasciz "f/F\tMeasure frequency (1s/FAST)\tr\tRead"
 
 	; HLP1013
 	.section .text.HLP1013, code
@@ -1178,7 +1178,7 @@ _MSG_1WIRE_LOOKUP_ID_HEADER_str:
 	.section .text.MSG_1WIRE_MACRO_LIST, code
 	.global _MSG_1WIRE_MACRO_LIST_str
 _MSG_1WIRE_MACRO_LIST_str:
-	.pasciz "1WIRE ROM COMMAND MACROs:\r\n 51.READ ROM (0x33) *for single device bus\r\n 85.MATCH ROM (0x55) *followed by 64bit address\r\n 204.SKIP ROM (0xCC) *followed by command\r\n 236.ALARM SEARCH (0xEC)\r\n 240.SEARCH ROM (0xF0)"
+	.pasciz "1WIRE ROM COMMAND MACROs:\r\n 51.READ ROM (0x33) *for single device bus\r\n 60.OVERDRIVE SKIP ROM (0x3C) *switches to overdrive speed\r\n 68.CONVERT T (0x44) + READ SCRATCHPAD (0xBE) *for roster thermometers\r\n 85.MATCH ROM (0x55) *followed by 64bit address\r\n 105.OVERDRIVE MATCH ROM (0x69) *followed by 64bit address\r\n 204.SKIP ROM (0xCC) *followed by command\r\n 236.ALARM SEARCH (0xEC)\r\n 240.SEARCH ROM (0xF0)"
 
 	; MSG_1WIRE_MACRO_MENU_HEADER
 	.section .text.MSG_1WIRE_MACRO_MENU_HEADER, code
@@ -1228,6 +1228,18 @@ _MSG_1WIRE_NO_DEVICE_str:
 _MSG_1WIRE_NO_DEVICE_DETECTED_str:
 	.pasciz "*No device detected "
 
+	; MSG_1WIRE_OVERDRIVE_MATCH_ROM_MACRO_NAME
+	.section .text.MSG_1WIRE_OVERDRIVE_MATCH_ROM_MACRO_NAME, code
+	.global _MSG_1WIRE_OVERDRIVE_MATCH_ROM_MACRO_NAME_str
+_MSG_1WIRE_OVERDRIVE_MATCH_ROM_MACRO_NAME_str:
+	.pasciz "OVERDRIVE MATCH ROM (0x69)"
+
+	; MSG_1WIRE_OVERDRIVE_SKIP_ROM_MACRO_NAME
+	.section .text.MSG_1WIRE_OVERDRIVE_SKIP_ROM_MACRO_NAME, code
+	.global _MSG_1WIRE_OVERDRIVE_SKIP_ROM_MACRO_NAME_str
+_MSG_1WIRE_OVERDRIVE_SKIP_ROM_MACRO_NAME_str:
+	.pasciz "OVERDRIVE SKIP ROM (0x3C)"
+
 	; MSG_1WIRE_PINS_STATE
 	.section .text.MSG_1WIRE_PINS_STATE, code
 	.global _MSG_1WIRE_PINS_STATE_str
@@ -1240,6 +1252,18 @@ _MSG_1WIRE_PINS_STATE_str:
 _MSG_1WIRE_READ_ROM_MACRO_NAME_str:
 	.pasciz "READ ROM (0x33): "
 
+	; MSG_1WIRE_ROSTER_CONVERT_MACRO_NAME
+	.section .text.MSG_1WIRE_ROSTER_CONVERT_MACRO_NAME, code
+	.global _MSG_1WIRE_ROSTER_CONVERT_MACRO_NAME_str
+_MSG_1WIRE_ROSTER_CONVERT_MACRO_NAME_str:
+	.pasciz "CONVERT T (0x44) + READ SCRATCHPAD (0xBE)"
+
+	; MSG_1WIRE_SCRATCHPAD_CRC_ERROR
+	.section .text.MSG_1WIRE_SCRATCHPAD_CRC_ERROR, code
+	.global _MSG_1WIRE_SCRATCHPAD_CRC_ERROR_str
+_MSG_1WIRE_SCRATCHPAD_CRC_ERROR_str:
+	.pasciz "CRC ERROR"
+
 	; MSG_1WIRE_SEARCH_MACRO_NAME
 	.section .text.MSG_1WIRE_SEARCH_MACRO_NAME, code
 	.global _MSG_1WIRE_SEARCH_MACRO_NAME_str
@@ -1606,11 +1630,17 @@ _MSG_RAW2WIRE_MACRO_MENU_str:
 _MSG_RAW2WIRE_MODE_HEADER_str:
 	.pasciz "R2W (spd hiz)=( "
 
+	; MSG_RAW3WIRE_HARDWARE_SPI_PROMPT
+	.section .text.MSG_RAW3WIRE_HARDWARE_SPI_PROMPT, code
+	.global _MSG_RAW3WIRE_HARDWARE_SPI_PROMPT_str
+_MSG_RAW3WIRE_HARDWARE_SPI_PROMPT_str:
+	.pasciz "Use hardware SPI for 8/16 bit transfers:\r\n 1. No *default\r\n 2. Yes (~50KHz, ~400KHz runs at 333KHz)"
+
 	; MSG_RAW3WIRE_MODE_HEADER
 	.section .text.MSG_RAW3WIRE_MODE_HEADER, code
 	.global _MSG_RAW3WIRE_MODE_HEADER_str
 _MSG_RAW3WIRE_MODE_HEADER_str:
-	.pasciz "R3W (spd csl hiz)=( "
+	.pasciz "R3W (spd csl hiz hw)=( "
 
 	; MSG_RAW_BRG_VALUE_INPUT
 	.section .text.MSG_RAW_BRG_VALUE_INPUT, code
@@ -1714,6 +1744,12 @@ _MSG_SPI_SAMPLE_PROMPT_str:
 _MSG_SPI_SPEED_PROMPT_str:
 	.pasciz "Set speed:\r\n 1.  30KHz\r\n 2. 125KHz\r\n 3. 250KHz\r\n 4.   1MHz\r\n 5.  50KHz\r\n 6. 1.3MHz\r\n 7.   2MHz\r\n 8. 2.6MHz\r\n 9. 3.2MHz\r\n10.   4MHz\r\n11. 5.3MHz\r\n12.   8MHz"
 
+	; MSG_UART_BRG_LOCKED
+	.section .text.MSG_UART_BRG_LOCKED, code
+	.global _MSG_UART_BRG_LOCKED_str
+_MSG_UART_BRG_LOCKED_str:
+	.pasciz "\n\rBRG locked to: \t"
+
 	; MSG_UART_MODE_IDENTIFIER
 	.section .text.MSG_UART_MODE_IDENTIFIER, code
 	.global _MSG_UART_MODE_IDENTIFIER_str
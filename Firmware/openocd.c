@@ -201,6 +201,9 @@ this will misbehave when polling is turned off in OpenOCD
 				buf[2] = inByte2;
 				binOpenOCDAnswer(buf, 3);
 
+				// the interrupt transfer shares the TX interrupt with the output queue
+				user_serial_wait_transmission_done();
+
 				// prepare the interrupt transfer
 				UART1RXBuf = (unsigned char*)bus_pirate_configuration.terminal_input;
 				UART1RXToRecv = 2*i;
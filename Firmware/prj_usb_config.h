@@ -7,6 +7,7 @@
 #define BAUDCLOCK_FREQ 16000000 
 #define UART_BAUD_setup(x)  U1BRG = x 
 #define CDC_FLUSH_MS 4 // how many ms timeout before cdc in to host is sent
+#define CDC_STREAM_FLUSH_MS 32 // same, while streaming and coalescing into full packets
 
 #define USB_INTERRUPTS 1
 
@@ -549,6 +549,9 @@ end:
                 case 'f': //bpWline("-frequency count on AUX");
                     bp_frequency_counter_setup();
                     break;
+                case 'F': //bpWline("-reciprocal frequency count on AUX");
+                    bp_reciprocal_frequency_counter_setup();
+                    break;
                 case 'g':
                     if (bus_pirate_configuration.bus_mode == BP_HIZ) { //bpWmessage(MSG_ERROR_MODE);
                         BPMSG1088;
@@ -747,7 +750,8 @@ bpv4reset:
                     bpBR;
                     break;
                 case 'D': //bpWline("-DVM mode");	//dumb voltmeter mode
-                    bp_adc_continuous_probe();
+                    repeat = getrepeat();
+                    bp_adc_continuous_probe((repeat > 1) ? repeat : 1);
                     break;
                 case '&': //bpWline("-delay 1ms");
                     repeat = getrepeat();
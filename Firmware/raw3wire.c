@@ -29,6 +29,26 @@
 #define R3WCLK_TRIS BP_CLK_DIR
 #define R3WMISO_TRIS BP_MISO_DIR
 
+/**
+ * Marker for bus speeds that the SPI peripheral cannot generate.
+ */
+#define RAW3WIRE_NO_SPI_PRESCALER 0xFF
+
+/**
+ * SPI1 prescaler bits (primary and secondary) for each bus speed, in
+ * bp_bitbang_speed_t order.
+ *
+ * The SPI clock cannot go below 31kHz, and 100kHz is not an exact prescaler
+ * ratio, so those speeds stay on bit-banging.  400kHz is not an exact ratio
+ * either, so the maximum speed uses the closest one that is not faster.
+ */
+static const uint8_t RAW3WIRE_SPI_PRESCALERS[] = {
+    RAW3WIRE_NO_SPI_PRESCALER, /* 5 kHz. */
+    0b00001100, /* 50 kHz - Primary prescaler 64:1 / Secondary prescaler 5:1 */
+    RAW3WIRE_NO_SPI_PRESCALER, /* 100 kHz. */
+    0b00010101  /* 333 kHz - Primary prescaler 16:1 / Secondary prescaler 3:1 */
+};
+
 extern mode_configuration_t mode_configuration;
 extern command_t last_command;
 extern bool command_error;
@@ -38,6 +58,36 @@ extern bool command_error;
  */
 static bool cs_line = LOW;
 
+/**
+ * Flag indicating whether 8 and 16 bits transfers should use the SPI
+ * peripheral, when the bus speed allows it.
+ */
+static bool hardware_spi = NO;
+
+/**
+ * Writes a value to the bus then reads a value back, using the SPI peripheral
+ * if possible.
+ *
+ * @param[in] value the value to write on the bus.
+ *
+ * @return the value read from the bus.
+ */
+static uint16_t raw3wire_transfer(const uint16_t value);
+
+/**
+ * Writes a value to the bus then reads a value back, using the SPI peripheral.
+ *
+ * The peripheral is only routed to the bus pins for the duration of the
+ * transfer, so bit-level operations keep working on plain I/O pins.
+ *
+ * @param[in] value the value to write on the bus.
+ * @param[in] prescaler the SPI1CON1 prescaler bits to use.
+ *
+ * @return the value read from the bus.
+ */
+static uint16_t raw3wire_spi_transfer(const uint16_t value,
+                                      const uint8_t prescaler);
+
 /**
  * Sets up the board for operating in Raw 3 Mode state.
  *
@@ -48,15 +98,83 @@ static bool cs_line = LOW;
 static void setup_raw3wire(const bool write_with_read,
                            const bool cs_line_state);
 
-uint16_t raw3wire_read(void) { return bitbang_read_with_write(0xFF); }
+uint16_t raw3wire_read(void) {
+  return raw3wire_transfer(mode_configuration.numbits == 16 ? 0xFFFF : 0xFF);
+}
 
 uint16_t raw3wire_write(const uint16_t value) {
   uint16_t read;
 
-  read = bitbang_read_with_write(value);
+  read = raw3wire_transfer(value);
   return mode_configuration.write_with_read ? read : 0;
 }
 
+uint16_t raw3wire_transfer(const uint16_t value) {
+  uint8_t prescaler;
+
+  if (hardware_spi && ((mode_configuration.numbits == 8) ||
+                       (mode_configuration.numbits == 16))) {
+    prescaler = RAW3WIRE_SPI_PRESCALERS[mode_configuration.speed];
+    if (prescaler != RAW3WIRE_NO_SPI_PRESCALER) {
+      return raw3wire_spi_transfer(value, prescaler);
+    }
+  }
+
+  return bitbang_read_with_write(value);
+}
+
+uint16_t raw3wire_spi_transfer(const uint16_t value, const uint8_t prescaler) {
+  uint16_t result;
+  bool mosi_direction;
+  bool clk_direction;
+
+  mosi_direction = R3WMOSI_TRIS;
+  clk_direction = R3WCLK_TRIS;
+
+  /*
+   * Master mode, clock idle LOW, data changing on the falling edge and
+   * sampled in the middle of the bit - the same timing bit-banging uses.
+   */
+  SPI1STATbits.SPIEN = OFF;
+  SPI1CON1 = (MASKBOTTOM8(prescaler, 5) << _SPI1CON1_PPRE_POSITION) |
+             (ON << _SPI1CON1_MSTEN_POSITION) |
+             (ON << _SPI1CON1_CKE_POSITION) |
+             ((mode_configuration.numbits == 16 ? ON : OFF)
+              << _SPI1CON1_MODE16_POSITION);
+  SPI1CON2 = 0x0000;
+  SPI1STAT = 0x0000;
+
+  /* Open drain outputs replace releasing the pins for high impedance. */
+  BP_MOSI_ODC = mode_configuration.high_impedance;
+  BP_CLK_ODC = mode_configuration.high_impedance;
+
+  /* Route the peripheral to the bus pins. */
+  RPINR20bits.SDI1R = BP_MISO_RPIN;
+  BP_MOSI_RPOUT = SDO1_IO;
+  BP_CLK_RPOUT = SCK1OUT_IO;
+  R3WMOSI_TRIS = OUTPUT;
+  R3WCLK_TRIS = OUTPUT;
+  R3WMISO_TRIS = INPUT;
+
+  SPI1STATbits.SPIEN = ON;
+  SPI1BUF = value;
+  while (!SPI1STATbits.SPIRBF) {
+  }
+  result = SPI1BUF;
+  SPI1STATbits.SPIEN = OFF;
+
+  /* Give the pins back to bit-banging. */
+  RPINR20bits.SDI1R = 0b11111;
+  BP_MOSI_RPOUT = 0b00000;
+  BP_CLK_RPOUT = 0b00000;
+  BP_MOSI_ODC = OFF;
+  BP_CLK_ODC = OFF;
+  R3WMOSI_TRIS = mosi_direction;
+  R3WCLK_TRIS = clk_direction;
+
+  return result;
+}
+
 void raw3wire_start_with_read(void) {
   setup_raw3wire(YES, !cs_line);
   MSG_SPI_CS_ENABLED;
@@ -78,6 +196,8 @@ void raw3wire_print_settings(void) {
   bp_write_dec_byte(cs_line);
   bpSP;
   bp_write_dec_byte(mode_configuration.high_impedance);
+  bpSP;
+  bp_write_dec_byte(hardware_spi);
   MSG_MODE_HEADER_END;
 }
 
@@ -86,6 +206,7 @@ void raw3wire_setup_prepare(void) {
   int speed;
   int output;
   int cs_line_low;
+  int hardware;
 
   consumewhitechars();
   speed = getint();
@@ -93,10 +214,14 @@ void raw3wire_setup_prepare(void) {
   cs_line_low = getint();
   consumewhitechars();
   output = getint();
+  consumewhitechars();
+  hardware = getint();
 
+  /* The hardware SPI setting is optional. */
   user_prompt = !(((speed > 0) && (speed <= 4)) &&
                   ((cs_line_low > 0) && (cs_line_low <= 2)) &&
-                  ((output > 0) && (output <= 2)));
+                  ((output > 0) && (output <= 2)) &&
+                  ((hardware >= 0) && (hardware <= 2)));
 
   if (user_prompt) {
     MSG_SOFTWARE_MODE_SPEED_PROMPT;
@@ -105,11 +230,14 @@ void raw3wire_setup_prepare(void) {
     cs_line = getnumber(2, 1, 2, 0) - 1;
     MSG_PIN_OUTPUT_TYPE_PROMPT;
     mode_configuration.high_impedance = (getnumber(1, 1, 2, 0) - 1) == 0;
+    MSG_RAW3WIRE_HARDWARE_SPI_PROMPT;
+    hardware_spi = (getnumber(1, 1, 2, 0) - 1) != 0;
     command_error = false;
   } else {
     mode_configuration.speed = speed - 1;
     cs_line = (cs_line_low - 1) != 0;
     mode_configuration.high_impedance = (output - 1) == 0;
+    hardware_spi = hardware == 2;
     raw3wire_print_settings();
   }
 
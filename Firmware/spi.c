@@ -522,6 +522,8 @@ uint8_t spi_write_byte(const uint8_t value) {
 void spi_sniffer(bool trigger, bool terminal_mode) {
   bool last_cs_line_state;
 
+  user_serial_set_flush_policy(USER_SERIAL_FLUSH_WHEN_FULL);
+
 restart:
 
   last_cs_line_state = HIGH;
@@ -626,8 +628,10 @@ restart:
   }
 
   spi_slave_disable();
+  user_serial_ringbuffer_release();
 
   spi_setup(spi_bus_speed[mode_configuration.speed]);
+  user_serial_set_flush_policy(USER_SERIAL_FLUSH_ON_REPLY);
 }
 
 void spi_slave_enable(void) {
@@ -826,6 +830,8 @@ void spi_enter_binary_io(void) {
         uint16_t bytes_to_write;
         uint16_t bytes_to_read;
         uint16_t offset;
+        const uint8_t *span;
+        uint8_t count;
 
         /* How many bytes to send to the bus. */
         bytes_to_write = (user_serial_read_byte() << 8) | user_serial_read_byte();
@@ -840,19 +846,22 @@ void spi_enter_binary_io(void) {
           break;
         }
 
-        /* Read data buffer from the serial port. */
-        for (offset = 0; offset < bytes_to_write; offset++) {
-          bus_pirate_configuration.terminal_input[offset] = user_serial_read_byte();
-        }
-
         /* Update the CS line if needed. */
         if (input_byte == SPI_BASE_COMMAND_WRITE_AND_READ_WITH_CS) {
           SPICS = LOW;
         }
 
-        /* Writes data to the SPI bus. */
-        for (offset = 0; offset < bytes_to_write; offset++) {
-          spi_write_byte(bus_pirate_configuration.terminal_input[offset]);
+        /* Writes data to the SPI bus, straight from the serial input. */
+        while (bytes_to_write > 0) {
+          count = user_serial_peek_span(&span);
+          if (count > bytes_to_write) {
+            count = bytes_to_write;
+          }
+          for (offset = 0; offset < count; offset++) {
+            spi_write_byte(span[offset]);
+          }
+          user_serial_consume_span(count);
+          bytes_to_write -= count;
         }
 
         /* Wait for the bus to settle. */
@@ -873,9 +882,7 @@ void spi_enter_binary_io(void) {
         REPORT_IO_SUCCESS();
 
         /* Output read data to the serial port. */
-        for (offset = 0; offset < bytes_to_read; offset++) {
-          user_serial_transmit_character(bus_pirate_configuration.terminal_input[offset]);
-        }
+        bp_write_buffer(bus_pirate_configuration.terminal_input, bytes_to_read);
 
         break;
       }
@@ -25,6 +25,7 @@
 
 #include "base.h"
 #include "core.h"
+#include "sump_rle.h"
 #include "uart.h"
 
 /*
@@ -33,11 +34,6 @@
  * http://dangerousprototypes.com/docs/The_Logic_Sniffer's_extended_SUMP_protocol
  *
  * @TODO: Add commands 0x0F, 0x9E, 0x9F from the extended SUMP protocol?
- * @TODO: Add "Set trigger configuration" command (0xC2, 0xC6, 0xCA, 0xCE).
- * @TODO: Check why samples are sent out backwards.
- * @TODO: Implement continuous sampling.
- * @TODO: Remove sump_command_t.left and turn the structure into two separate
- *        fields.
  */
 
 /**
@@ -98,6 +94,19 @@
  */
 #define SUMP_DESC 0x04
 
+/**
+ * Start continuous sampling (Bus Pirate extension).
+ *
+ * Samples are taken at the rate set by SUMP_DIV and streamed to the host as
+ * they are acquired, until any byte is received.  Trigger, read and delay
+ * counts are ignored.  If the link cannot keep up and samples have to be
+ * dropped, SUMP_STREAM_ESCAPE followed by SUMP_STREAM_OVERRUN is sent where
+ * the gap is.  A sample equal to SUMP_STREAM_ESCAPE is sent twice, so all
+ * probes stay available.  Receiving SUMP_RESET also leaves SUMP mode, any
+ * other byte just stops the stream.
+ */
+#define SUMP_STREAM 0x08
+
 /**
  * Put transmitter out of pause mode.
  *
@@ -176,6 +185,16 @@
  */
 #define SUMP_FLAGS 0x82
 
+/**
+ * SUMP_FLAGS bit enabling run length encoding of captured samples (flag
+ * bit 8, found in the second parameter byte).
+ *
+ * When enabled, an entry with bit 7 set is a count rather than a sample: its
+ * lower seven bits tell for how many more samples the previous sample value
+ * was held.  Long runs are split over more than one count entry.
+ */
+#define SUMP_FLAGS_RLE_ENABLE 0x01
+
 /**
  * Set Trigger Values.
  *
@@ -206,6 +225,42 @@
  */
 #define SUMP_TRIG_VALS 0xC1
 
+/**
+ * Set trigger configuration.
+ *
+ * Configures the trigger stage selected by bits 2 and 3 of the opcode, in the
+ * same order as above.
+ *
+ * - delay: How many samples to wait after the stage matched before acting.
+ * - level: Trigger level at which the stage becomes active.
+ * - channel: Channel to read bits from, in serial mode.
+ * - serial: Matches the last 32 samples of the selected channel instead of
+ *           the current value of all channels.
+ * - start: Starts the capture when the stage matches.  When not set, a match
+ *          moves the trigger to the next level instead.
+ *
+ *          LSB            MSB
+ * 1100xx10 XXXXXXXXXXXXXXXX YY??CCCC C?SA????
+ *          |||||||||||||||| ||  |||| | ||
+ *          |||||||||||||||| ||  |||| | |+------ Start
+ *          |||||||||||||||| ||  |||| | +------- Serial
+ *          |||||||||||||||| ||  ++++-+--------- Channel
+ *          |||||||||||||||| ++----------------- Level
+ *          ++++++++++++++++-------------------- Delay
+ */
+#define SUMP_TRIG_CONF 0xC2
+
+/**
+ * Mask selecting the trigger commands (SUMP_TRIG, SUMP_TRIG_VALS, and
+ * SUMP_TRIG_CONF) for all stages.
+ */
+#define SUMP_TRIG_COMMAND_MASK 0xF0
+
+/**
+ * How many trigger stages are available.
+ */
+#define SUMP_TRIGGER_STAGES 4
+
 /**
  * Not used, key means end of metadata.
  */
@@ -271,15 +326,224 @@
  */
 #define BP_SUMP_SAMPLE_MEMORY_SIZE BP_TERMINAL_BUFFER_SIZE
 
+/*
+ * Probe pins mapping.
+ *
+ * v3: CS, MISO, CLK, MOSI, AUX on RB6-RB10, channels 0-4.
+ * v4: AUX2, MOSI, CLK, MISO, CS, AUX0 on RD0-RD5, channels 0-5.  AUX1 is on
+ *     RD8, and is either moved to channel 7 in software or green-wired to RD7.
+ */
+
+#ifdef BUSPIRATEV4
+
+/**
+ * Port the probes are read from.
+ */
+#define BP_SUMP_PROBES_PORT PORTD
+
+/**
+ * Position of the first probe in BP_SUMP_PROBES_PORT.
+ */
+#define BP_SUMP_PROBES_SHIFT 0
+
+#ifdef BPv4_SUMP_SOFT_WIRE
+
+/**
+ * The probes cannot be read with a single shift, as AUX1 has to be moved from
+ * RD8 to channel 7.
+ */
+#define BP_SUMP_SOFT_WIRED_PROBES
+
+/**
+ * Reads the current probes state.
+ */
+#define SUMP_READ_PROBES()                                                     \
+  ((uint8_t)((PORTD & 0x3F) | ((PORTD >> 1) & 0x80)))
+
+#endif /* BPv4_SUMP_SOFT_WIRE */
+
+#elif defined(BUSPIRATEV3)
+
+/**
+ * Port the probes are read from.
+ */
+#define BP_SUMP_PROBES_PORT PORTB
+
+/**
+ * Position of the first probe in BP_SUMP_PROBES_PORT.
+ */
+#define BP_SUMP_PROBES_SHIFT 6
+
+#else
+#error "Invalid or unknown Bus Pirate version!"
+#endif /* BUSPIRATEV4 || BUSPIRATEV3 */
+
+#ifndef SUMP_READ_PROBES
+
+/**
+ * Reads the current probes state.
+ */
+#define SUMP_READ_PROBES()                                                     \
+  ((uint8_t)((BP_SUMP_PROBES_PORT >> BP_SUMP_PROBES_SHIFT) &                   \
+             BP_SUMP_PROBES_MASK))
+
+#endif /* !SUMP_READ_PROBES */
+
+/**
+ * Shortest sampling period the timer paced capture loops can keep up with,
+ * in instruction cycles (500kHz).
+ *
+ * This holds for plain captures, RLE captures, and captures waiting for a
+ * single immediate parallel trigger stage.  Other trigger setups may still
+ * fall behind, see sump_acquire_samples().
+ */
+#define BP_SUMP_TIMED_MINIMUM_PERIOD (FCY / 500000UL)
+
+#if defined(BP_SUMP_PACKED_SAMPLES) || defined(BP_SUMP_SOFT_WIRED_PROBES)
+
+/**
+ * The highest sample rate for the Bus Pirate to sample data at, in Hz.
+ *
+ * The fixed rate capture loops cannot be used here, so this is the rate the
+ * timer paced loops can keep up with.
+ */
+#define BP_SUMP_MAXIMUM_SAMPLE_RATE (FCY / BP_SUMP_TIMED_MINIMUM_PERIOD)
+
+#else
+
 /**
  * The highest sample rate for the Bus Pirate to sample data at, in Hz.
+ *
+ * This is the rate of the fastest fixed rate capture loop in sump_asm.s.
  */
-#define BP_SUMP_MAXIMUM_SAMPLE_RATE 1000000
+#define BP_SUMP_MAXIMUM_SAMPLE_RATE (FCY / 4)
+
+#endif /* BP_SUMP_PACKED_SAMPLES || BP_SUMP_SOFT_WIRED_PROBES */
+
+#ifdef BP_SUMP_PACKED_SAMPLES
+
+/**
+ * How many probes the Bus Pirate can use.
+ */
+#define BP_SUMP_PROBES_COUNT 4
+
+/**
+ * How many samples are stored in each byte of sample memory.
+ */
+#define BP_SUMP_SAMPLES_PER_BYTE 2
+
+#else
 
 /**
  * How many probes the Bus Pirate can use.
  */
-#define BP_SUMP_PROBES_COUNT 5
+#define BP_SUMP_PROBES_COUNT NUM_OF_SUMP_CHANNELS
+
+/**
+ * How many samples are stored in each byte of sample memory.
+ */
+#define BP_SUMP_SAMPLES_PER_BYTE 1
+
+#endif /* BP_SUMP_PACKED_SAMPLES */
+
+/**
+ * How many samples fit in the sample memory.
+ */
+#define BP_SUMP_SAMPLE_CAPACITY                                                \
+  (BP_SUMP_SAMPLE_MEMORY_SIZE * BP_SUMP_SAMPLES_PER_BYTE)
+
+/**
+ * Mask of the sample bits carrying probe data.
+ */
+#define BP_SUMP_PROBES_MASK ((1U << BP_SUMP_PROBES_COUNT) - 1)
+
+/**
+ * Escape byte in streamed samples.
+ *
+ * It has bit 7 set, so it can only show up as a sample on boards with eight
+ * probes.
+ */
+#define SUMP_STREAM_ESCAPE 0xA5
+
+/**
+ * Byte following SUMP_STREAM_ESCAPE where streamed samples were dropped.
+ */
+#define SUMP_STREAM_OVERRUN 0x00
+
+/**
+ * Appends a byte to the streaming ring buffer, room must have been checked.
+ */
+#define SUMP_STREAM_PUSH(value)                                                  do {                                                                             bus_pirate_configuration.terminal_input[stream_head] = (value);                stream_head = (stream_head + 1) & (BP_SUMP_SAMPLE_MEMORY_SIZE - 1);          } while (0)
+
+/**
+ * Shortest sampling period allowed when streaming, in instruction cycles.
+ *
+ * Each sample costs an interrupt, so the rate is capped to leave enough
+ * cycles for the main loop to drain the buffer (100kHz).
+ */
+#define BP_SUMP_STREAM_MINIMUM_PERIOD (FCY / 100000UL)
+
+#if (BP_SUMP_SAMPLE_MEMORY_SIZE & (BP_SUMP_SAMPLE_MEMORY_SIZE - 1)) != 0
+#error "BP_SUMP_SAMPLE_MEMORY_SIZE must be a power of two"
+#endif /* BP_SUMP_SAMPLE_MEMORY_SIZE not a power of two */
+
+#ifdef BP_SUMP_PACKED_SAMPLES
+
+/**
+ * Stores the given sample at the given sample offset.
+ *
+ * Samples at even offsets are held in `pending` and written out together with
+ * the following odd sample, which ends up in the high nibble.
+ */
+#define SUMP_STORE_SAMPLE(offset, pending, sample)                             \
+  do {                                                                         \
+    if ((offset) & 1) {                                                        \
+      bus_pirate_configuration.terminal_input[(offset) >> 1] =                 \
+          (pending) | (((sample) & 0x0F) << 4);                                \
+    } else {                                                                   \
+      (pending) = (sample) & 0x0F;                                             \
+    }                                                                          \
+  } while (0)
+
+/**
+ * Writes out a sample held by SUMP_STORE_SAMPLE, if the capture ended on an
+ * even offset.
+ */
+#define SUMP_FLUSH_SAMPLE(offset, pending)                                     \
+  do {                                                                         \
+    if ((offset) & 1) {                                                        \
+      bus_pirate_configuration.terminal_input[(offset) >> 1] = (pending);      \
+    }                                                                          \
+  } while (0)
+
+/**
+ * Retrieves the sample stored at the given offset.
+ */
+#define SUMP_LOAD_SAMPLE(offset)                                               \
+  (((offset) & 1)                                                              \
+       ? (bus_pirate_configuration.terminal_input[(offset) >> 1] >> 4)         \
+       : (bus_pirate_configuration.terminal_input[(offset) >> 1] & 0x0F))
+
+#else
+
+/**
+ * Stores the given sample at the given sample offset.
+ */
+#define SUMP_STORE_SAMPLE(offset, pending, sample)                             \
+  bus_pirate_configuration.terminal_input[(offset)] = (sample)
+
+/**
+ * Writes out a sample held by SUMP_STORE_SAMPLE (no-op when unpacked).
+ */
+#define SUMP_FLUSH_SAMPLE(offset, pending)
+
+/**
+ * Retrieves the sample stored at the given offset.
+ */
+#define SUMP_LOAD_SAMPLE(offset)                                               \
+  bus_pirate_configuration.terminal_input[(offset)]
+
+#endif /* BP_SUMP_PACKED_SAMPLES */
 
 /**
  * SUMP protocol version the Bus Pirate supports.
@@ -288,6 +552,8 @@
 
 /**
  * SUMP metadata information for the Bus Pirate device.
+ *
+ * The firmware version and the end marker are sent separately.
  */
 static const uint8_t SUMP_METADATA[] = {
     /* Device name. */
@@ -301,15 +567,15 @@ static const uint8_t SUMP_METADATA[] = {
 #error "Invalid or unknown Bus Pirate version!"
 #endif /* BUSPIRATEV4 || BUSPIRATEV3 */
 
-    /* Sample memory (4096 bytes). */
+    /* Sample memory (4096 or 8192 samples). */
 
     SUMP_METADATA_SAMPLE_MEMORY_AVAILABLE,
-    (uint8_t)((uint32_t)BP_SUMP_SAMPLE_MEMORY_SIZE >> 24),
-    (uint8_t)(((uint32_t)BP_SUMP_SAMPLE_MEMORY_SIZE >> 16) & 0xFF),
-    (uint8_t)(((uint32_t)BP_SUMP_SAMPLE_MEMORY_SIZE >> 8) & 0xFF),
-    (uint8_t)((uint32_t)BP_SUMP_SAMPLE_MEMORY_SIZE & 0xFF),
+    (uint8_t)((uint32_t)BP_SUMP_SAMPLE_CAPACITY >> 24),
+    (uint8_t)(((uint32_t)BP_SUMP_SAMPLE_CAPACITY >> 16) & 0xFF),
+    (uint8_t)(((uint32_t)BP_SUMP_SAMPLE_CAPACITY >> 8) & 0xFF),
+    (uint8_t)((uint32_t)BP_SUMP_SAMPLE_CAPACITY & 0xFF),
 
-    /* Sample rate (1MHz). */
+    /* Sample rate (4MHz, or 500kHz with packed or soft-wired samples). */
 
     SUMP_METADATA_MAXIMUM_SAMPLE_RATE,
     (uint8_t)((uint32_t)BP_SUMP_MAXIMUM_SAMPLE_RATE >> 24),
@@ -317,15 +583,53 @@ static const uint8_t SUMP_METADATA[] = {
     (uint8_t)(((uint32_t)BP_SUMP_MAXIMUM_SAMPLE_RATE >> 8) & 0xFF),
     (uint8_t)((uint32_t)BP_SUMP_MAXIMUM_SAMPLE_RATE & 0xFF),
 
-    /* Number of probes (5). */
+    /* Number of probes (4, 5, or 8). */
 
     SUMP_METADATA_USABLE_PROBES_SHORT_NUMBER, BP_SUMP_PROBES_COUNT,
 
     /* Protocol version (v2). */
 
-    SUMP_METADATA_PROTOCOL_SHORT_VERSION, BP_SUMP_PROTOCOL_VERSION,
+    SUMP_METADATA_PROTOCOL_SHORT_VERSION, BP_SUMP_PROTOCOL_VERSION};
+
+/**
+ * Trigger stage configuration and matching state.
+ */
+typedef struct {
+  /** Which bits of the sample (or of the serial history) must match. */
+  uint32_t mask;
+
+  /** The value the masked bits must have. */
+  uint32_t value;
+
+  /** The last 32 bits seen on the selected channel, in serial mode. */
+  uint32_t history;
+
+  /** How many samples to wait before acting on a match. */
+  uint16_t delay;
+
+  /** Trigger level at which the stage becomes active. */
+  uint8_t level;
+
+  /** Channel whose bits are matched in serial mode. */
+  uint8_t channel;
 
-    SUMP_METADATA_END};
+  /** Flag indicating whether the stage matches serial data. */
+  bool serial;
+
+  /** Flag indicating whether a match starts the capture. */
+  bool start;
+} sump_trigger_stage_t;
+
+/**
+ * Long commands have the most significant bit set, and carry four parameter
+ * bytes.
+ */
+#define SUMP_LONG_COMMAND_FLAG 0x80
+
+/**
+ * How many parameter bytes follow a long command.
+ */
+#define SUMP_LONG_COMMAND_PARAMETERS 4
 
 /**
  * SUMP_ID response buffer, advertise ourselves as a Logic Sniffer.
@@ -346,7 +650,10 @@ typedef enum {
   SAMPLER_IDLE = 0,
 
   /** Sampler is either ready for acquisition or is currently acquiring. */
-  SAMPLER_ARMED
+  SAMPLER_ARMED,
+
+  /** Sampler is continuously streaming samples to the host. */
+  SAMPLER_STREAMING
 } sump_sampler_state_t;
 
 /**
@@ -357,10 +664,7 @@ typedef enum {
   RX_COMMAND_IDLE = 0,
 
   /** A long command was received, and parameters need to be acquired. */
-  RX_COMMAND_PARAMETERS,
-
-  /** A fully formed command was received and is being processed. */
-  RX_COMMAND_PROCESS
+  RX_COMMAND_PARAMETERS
 } sump_analyzer_command_state_t;
 
 /**
@@ -369,21 +673,7 @@ typedef enum {
  * A SUMP command can be up to 5 bytes long (SUMP_DIV, SUMP_CNT, SUMP_FLAGS,
  * SUMP_TRIG, SUMP_TRIG_VALS).
  */
-#define SUMP_COMMAND_BUFFER_LENGTH 5
-
-/**
- * SUMP command storage structure.
- */
-typedef struct {
-  /** Command bytes storage buffer. */
-  uint8_t bytes[SUMP_COMMAND_BUFFER_LENGTH];
-
-  /** How many parameter bytes still need to be obtained. */
-  uint8_t left;
-
-  /** How many parameter bytes have been obtained so far. */
-  uint8_t count;
-} __attribute__((packed)) sump_command_t;
+#define SUMP_COMMAND_BUFFER_LENGTH (SUMP_LONG_COMMAND_PARAMETERS + 1)
 
 /**
  * The current state of the sampler.
@@ -397,16 +687,101 @@ static sump_analyzer_command_state_t command_processor_state = RX_COMMAND_IDLE;
 
 /**
  * How many bytes should be acquired in the next sampling operation, in bytes.
+ *
+ * This is the SUMP read count, and includes samples taken before the trigger.
  */
 static unsigned int samples_to_acquire;
 
+/**
+ * How many samples should be acquired after the trigger fired.
+ *
+ * This is the SUMP delay count.  When it is smaller than samples_to_acquire,
+ * the difference is made of samples taken before the trigger fired.
+ */
+static unsigned int samples_after_trigger;
+
+/**
+ * Trigger stages.
+ */
+static sump_trigger_stage_t trigger_stages[SUMP_TRIGGER_STAGES];
+
+/**
+ * The current trigger level.
+ */
+static uint8_t trigger_level;
+
+/**
+ * How many samples are left before a matched start stage fires the trigger,
+ * or zero if no start stage matched yet.
+ */
+static uint16_t trigger_countdown;
+
+/**
+ * Flag indicating whether the trigger is a single immediate parallel stage,
+ * which the capture loops match inline rather than via sump_trigger_check().
+ */
+static bool trigger_simple;
+
+/**
+ * Mask of the single immediate parallel stage, if trigger_simple is set.
+ */
+static uint8_t trigger_simple_mask;
+
+/**
+ * Value of the single immediate parallel stage, if trigger_simple is set.
+ */
+static uint8_t trigger_simple_value;
+
+/**
+ * Tells whether the given sample fires the trigger.
+ *
+ * The common single stage value/mask trigger is matched inline, as a full
+ * sump_trigger_check() call does not fit in a sample period at high rates.
+ */
+#define SUMP_TRIGGER_MATCH(sample)                                             \
+  (trigger_simple                                                              \
+       ? ((((sample) ^ trigger_simple_value) & trigger_simple_mask) == 0)      \
+       : sump_trigger_check(sample))
+
+/**
+ * The requested sampling period, in instruction cycles.
+ */
+static uint32_t sample_period;
+
+/**
+ * Flag indicating whether captures should be run length encoded.
+ */
+static bool rle_enabled;
+
+/**
+ * Streaming ring buffer write offset, owned by the timer interrupt.
+ */
+static volatile uint16_t stream_head;
+
+/**
+ * Streaming ring buffer read offset, owned by the main loop.
+ */
+static volatile uint16_t stream_tail;
+
+/**
+ * Flag indicating that samples were dropped since the last stored one.
+ */
+static volatile bool stream_overrun;
+
 /**
  * Acquires data from the probes and sends it out to the controlling software.
  *
- * This function will acquire up to BP_SUMP_SAMPLE_MEMORY_SIZE, by using the
+ * This function will acquire up to BP_SUMP_SAMPLE_CAPACITY, by using the
  * value read from the samples_to_acquire variable.  Calling this function
  * where the sampler is not armed will not trigger any action.
  *
+ * If pre-trigger samples are requested, the terminal buffer is filled in a
+ * circular fashion until the trigger fires, then samples_after_trigger more
+ * samples are taken.  Above BP_SUMP_TIMED_MINIMUM_PERIOD rates the fixed rate
+ * loops are used instead, with no pre-trigger samples.  Samples are sent out
+ * starting from the most recent one, as the SUMP protocol mandates - clients
+ * reverse the data themselves.
+ *
  * To avoid rewriting interrupt vectors with the bootloader, this firmware
  * currently uses polling to read the trigger and timer.  A final version
  * should use interrupts after lots of testing.
@@ -420,6 +795,92 @@ static bool sump_acquire_samples(void);
  */
 static void sump_reset(void);
 
+/**
+ * Captures run length encoded samples into the terminal buffer.
+ *
+ * Timer #4 must already be running.  Entries are written starting from the
+ * beginning of the buffer, wrapping around while waiting for the trigger.
+ * Once the trigger fires, entries are written until samples_to_capture of
+ * them are stored, the last one being the count of the run in progress if
+ * there is one.
+ *
+ * @param[in] pre_trigger true if the capture should wait for the trigger.
+ * @param[in] samples_to_capture how many entries to store after the trigger.
+ * @param[out] end_offset the offset right after the last entry written.
+ * @param[out] late set to true if a sample could not be taken in time, in
+ *             which case the capture stops right away.
+ *
+ * @return true if the capture completed, false if it was aborted to let a
+ *         pending command through.
+ */
+static bool sump_capture_rle(const bool pre_trigger,
+                             const size_t samples_to_capture,
+                             size_t *end_offset, bool *late);
+
+/**
+ * Tells whether any trigger stage has been set up.
+ *
+ * @return true if the capture should wait for a trigger, false if it should
+ *         start right away.
+ */
+static bool sump_trigger_enabled(void);
+
+/**
+ * Resets the trigger matching state before a capture.
+ */
+static void sump_trigger_arm(void);
+
+/**
+ * Feeds the given sample to the trigger stages.
+ *
+ * @param[in] sample the sample just taken.
+ *
+ * @return true if the trigger fired with this sample, false otherwise.
+ */
+static bool sump_trigger_check(const uint8_t sample);
+
+/**
+ * Fixed rate capture loop signature.
+ *
+ * @param[out] buffer the buffer to store samples into.
+ * @param[in] count how many samples to take, must be a multiple of 4.
+ * @param[in] port the port register to sample.
+ * @param[in] shift how many bits the port value is shifted right by.
+ */
+typedef void (*sump_fixed_rate_capture_t)(uint8_t *buffer, uint16_t count,
+                                          volatile uint16_t *port,
+                                          uint16_t shift);
+
+/* Fixed rate capture loops, see sump_asm.s. */
+
+extern void sump_capture_4mhz(uint8_t *buffer, uint16_t count,
+                              volatile uint16_t *port, uint16_t shift);
+extern void sump_capture_2mhz(uint8_t *buffer, uint16_t count,
+                              volatile uint16_t *port, uint16_t shift);
+extern void sump_capture_1mhz(uint8_t *buffer, uint16_t count,
+                              volatile uint16_t *port, uint16_t shift);
+
+/**
+ * Returns the fixed rate capture loop matching the requested sampling period.
+ *
+ * @return the capture loop to use, or NULL if the timer-paced loop should be
+ *         used instead.
+ */
+static sump_fixed_rate_capture_t sump_fixed_rate_capture(void);
+
+/**
+ * Starts continuous sampling into the streaming ring buffer.
+ *
+ * Samples are taken by the timer #5 interrupt handler and drained by
+ * sump_acquire_samples() as fast as the serial link allows.
+ */
+static void sump_start_streaming(void);
+
+/**
+ * Stops continuous sampling.
+ */
+static void sump_stop_streaming(void);
+
 /**
  * Processes the given byte as a part of a SUMP command.
  *
@@ -428,14 +889,47 @@ static void sump_reset(void);
  */
 static bool sump_handle_command_byte(uint8_t input_byte);
 
+/**
+ * Executes a fully received long command.
+ *
+ * @param[in] command the command byte followed by its four parameter bytes.
+ */
+static void sump_handle_long_command(const uint8_t *command);
+
+/**
+ * Sends the device metadata, in reply to SUMP_DESC.
+ */
+static void sump_send_metadata(void);
+
+/**
+ * Handles a byte received while captured samples are being sent.
+ *
+ * SUMP_XOFF pauses the transmission until SUMP_XON (or any other byte but
+ * SUMP_RESET) is received.
+ *
+ * @param[in] input_byte the byte that was received.
+ *
+ * @return false if a SUMP_RESET command was received and the transmission
+ *         must be aborted, true otherwise.
+ */
+static bool sump_handle_flow_control(uint8_t input_byte);
+
 void enter_sump_mode(void) {
 
   /* Set probing channels to INPUT mode. */
+#ifdef BUSPIRATEV4
+  IODIR |= AUX0 + AUX1 + AUX2 + MOSI + CLK + MISO + CS + SUMP_SPARE6 +
+           SUMP_SPARE7;
+#else
   IODIR |= AUX + MOSI + CLK + MISO + CS;
+#endif /* BUSPIRATEV4 */
 
   /* Reset the analyzer state. */
   sump_reset();
 
+  /* Coalesce captured samples into full USB packets. */
+  user_serial_set_flush_policy(USER_SERIAL_FLUSH_WHEN_FULL);
+
   /* Trigger the device ID broadcast response. */
   sump_handle_command_byte(SUMP_ID);
 
@@ -449,7 +943,7 @@ void enter_sump_mode(void) {
       if (sump_handle_command_byte(user_serial_read_byte())) {
 
         /* A SUMP_RESET command was received, abort. */
-        return;
+        break;
       }
     }
 
@@ -460,35 +954,46 @@ void enter_sump_mode(void) {
     if (sump_acquire_samples()) {
 
       /* The acquisition process finished, end. */
-      return;
+      break;
     }
   }
+
+  user_serial_set_flush_policy(USER_SERIAL_FLUSH_ON_REPLY);
 }
 
 void sump_reset(void) {
   /* Switch LED off. */
   BP_LEDMODE = OFF;
 
-  /* Switch pull-ups off for all pins. */
+  /* Switch pull-ups off for the probe pins. */
+#ifdef BUSPIRATEV4
+  CNPU1 &= 0b1001111111111111;
+  CNPU4 &= 0b1111111111000001;
+#else
   CNPU1 = 0;
   CNPU2 = 0;
-
-  /* Disable change notification for all pins. */
-  CNEN1 = 0;
-  CNEN2 = 0;
+#endif /* BUSPIRATEV4 */
 
   /* Stop timer #4. */
   T4CON = 0;
 
-  /* Disable change notification interrupts (set priority to 0). */
-  IPC4bits.CNIP = 0;
+  /* Disable timer #5 interrupts. */
+  IEC1bits.T5IE = OFF;
 
   /* Setup timer periods. */
-  PR5 = HI16(BP_DEFAULT_TIMER_PERIOD);
-  PR4 = LO16(BP_DEFAULT_TIMER_PERIOD);
+  PR5 = HI16(BP_DEFAULT_TIMER_PERIOD - 1);
+  PR4 = LO16(BP_DEFAULT_TIMER_PERIOD - 1);
+  sample_period = BP_DEFAULT_TIMER_PERIOD;
 
-  /* Default to acquire a full buffer. */
-  samples_to_acquire = BP_SUMP_SAMPLE_MEMORY_SIZE;
+  /* Default to acquire a full buffer, with no pre-trigger samples. */
+  samples_to_acquire = BP_SUMP_SAMPLE_CAPACITY;
+  samples_after_trigger = BP_SUMP_SAMPLE_CAPACITY;
+
+  /* Store raw samples. */
+  rle_enabled = false;
+
+  /* Clear all trigger stages. */
+  memset(trigger_stages, 0, sizeof(trigger_stages));
 
   /* Initialize the sampler. */
   sampler_state = SAMPLER_IDLE;
@@ -500,9 +1005,22 @@ bool sump_handle_command_byte(unsigned char input_byte) {
    * The command storage buffer.
    *
    * No need to clear it first, as it will be properly initialized upon
-   * receiving a long (5 bytes) command.
+   * receiving a long (5 bytes) command.  It must persist across calls, as
+   * long commands arrive one byte per call.
    */
-  sump_command_t command_buffer = {.bytes = {0}, .count = 0, .left = 0};
+  static uint8_t command_bytes[SUMP_COMMAND_BUFFER_LENGTH];
+
+  /* How many bytes of the current long command have been obtained so far. */
+  static uint8_t command_length = 0;
+
+  /* Any incoming byte stops a running stream. */
+  if (sampler_state == SAMPLER_STREAMING) {
+    sump_stop_streaming();
+
+    if (input_byte != SUMP_RESET) {
+      return false;
+    }
+  }
 
   switch (command_processor_state) {
 
@@ -537,40 +1055,38 @@ bool sump_handle_command_byte(unsigned char input_byte) {
       /* Timer #4 counter will be 32 bits wide. */
       T4CONbits.T32 = ON;
 
-      /* Clear change notification interrupt flag. */
-      IFS1bits.CNIF = OFF;
-
-      /* Disable change notification interrupts. */
-      IEC1bits.CNIE = OFF;
-
-      /* Set change notification interrupt priority to 1. */
-      IPC4bits.CNIP = 1;
+      /* Start matching triggers from the first level. */
+      sump_trigger_arm();
 
       /* Update sampler state. */
       sampler_state = SAMPLER_ARMED;
       break;
 
+    /* Start continuous sampling. */
+    case SUMP_STREAM:
+      sump_start_streaming();
+      break;
+
     /* Send device description. */
     case SUMP_DESC:
-      bp_write_buffer(SUMP_METADATA, sizeof(SUMP_METADATA));
+      sump_send_metadata();
       break;
 
     /* Start/Stop data flow. */
     case SUMP_XON:
     case SUMP_XOFF:
-      /* Stop and resume are not supported yet. */
+      /* Only meaningful while samples are being sent. */
       break;
 
-    /* It must be a long command then. */
     default:
-      /* Store the first byte. */
-      command_buffer.bytes[0] = input_byte;
-
-      /* Update counters. */
-      command_buffer.left = 4;
-      command_buffer.count = 0;
+      /* Unknown short commands are ignored. */
+      if (!(input_byte & SUMP_LONG_COMMAND_FLAG)) {
+        break;
+      }
 
-      /* Update state. */
+      /* Store the first byte and wait for the parameters. */
+      command_bytes[0] = input_byte;
+      command_length = 1;
       command_processor_state = RX_COMMAND_PARAMETERS;
       break;
     }
@@ -579,143 +1095,582 @@ bool sump_handle_command_byte(unsigned char input_byte) {
 
   /* Keep reading parameter data. */
   case RX_COMMAND_PARAMETERS:
+    command_bytes[command_length++] = input_byte;
+
+    /* Process the command once all parameters are in. */
+    if (command_length == SUMP_COMMAND_BUFFER_LENGTH) {
+      command_processor_state = RX_COMMAND_IDLE;
+      sump_handle_long_command(command_bytes);
+    }
+
+    break;
+  }
+
+  return false;
+}
 
-    /* Update command count. */
-    command_buffer.count++;
+void sump_handle_long_command(const uint8_t *command) {
+  /* Set up a trigger stage. */
+  if ((command[0] & SUMP_TRIG_COMMAND_MASK) == SUMP_TRIG) {
+    sump_trigger_stage_t *stage;
+    uint32_t parameter;
 
-    /* Fill buffer. */
-    command_buffer.bytes[command_buffer.count] = input_byte;
+    stage = &trigger_stages[(command[0] >> 2) & (SUMP_TRIGGER_STAGES - 1)];
+    parameter = ((uint32_t)command[4] << 24) | ((uint32_t)command[3] << 16) |
+                ((uint32_t)command[2] << 8) | (uint32_t)command[1];
 
-    /* Check whether the buffer is full or not. */
-    if (command_buffer.count < command_buffer.left) {
+    switch (command[0] & 0x03) {
+    case SUMP_TRIG & 0x03:
+      stage->mask = parameter;
+      break;
+
+    case SUMP_TRIG_VALS & 0x03:
+      stage->value = parameter;
+      break;
+
+    case SUMP_TRIG_CONF & 0x03:
+      stage->delay = LO16(parameter);
+      stage->level = (parameter >> 16) & 0x03;
+      stage->channel = (parameter >> 20) & 0x1F;
+      stage->serial = (parameter & (1UL << 26)) != 0;
+      stage->start = (parameter & (1UL << 27)) != 0;
+      break;
+
+    default:
       break;
     }
 
-  /* Intentional fall-through. */
+    return;
+  }
 
-  /* Process the fully read command buffer. */
-  case RX_COMMAND_PROCESS:
-    switch (command_buffer.bytes[0]) {
-    /* Set triggers. */
-    case SUMP_TRIG:
+  switch (command[0]) {
 
-      /* Set a trigger on the AUX pin. */
-      if (command_buffer.bytes[1] & 0b00010000) {
-        CNEN2 |= 0b0000000000000001;
-      }
+  case SUMP_FLAGS:
+#ifdef BP_SUMP_PACKED_SAMPLES
+    /* RLE entries need a whole byte, so it is not available here. */
+    rle_enabled = false;
+#else
+    rle_enabled = (command[2] & SUMP_FLAGS_RLE_ENABLE) != 0;
+#endif /* BP_SUMP_PACKED_SAMPLES */
+    break;
 
-      /* Set a trigger on the ??? pin. */
-      if (command_buffer.bytes[1] & 0b00001000) {
-        CNEN2 |= 0b0000000000100000;
-      }
+  /* Read requested samples buffer size. */
+  case SUMP_CNT:
+    samples_to_acquire = (((command[2] << 8) + command[1]) + 1) * 4;
 
-      /* Set a trigger on the ??? pin. */
-      if (command_buffer.bytes[1] & 0b00000100) {
-        CNEN2 |= 0b0000000001000000;
-      }
+    samples_after_trigger = (((command[4] << 8) + command[3]) + 1) * 4;
 
-      /* Set a trigger on the ??? pin. */
-      if (command_buffer.bytes[1] & 0b00000010) {
-        CNEN2 |= 0b0000000010000000;
-      }
+    /* Clamp sample counter if more bytes are requested. */
+    if (samples_to_acquire > BP_SUMP_SAMPLE_CAPACITY) {
+      samples_to_acquire = BP_SUMP_SAMPLE_CAPACITY;
+    }
 
-      /* Set a trigger on the ??? pin. */
-      if (command_buffer.bytes[1] & 0b00000001) {
-        CNEN2 |= 0b0000000100000000;
-      }
+    /* Samples after the trigger are part of the samples being read. */
+    if (samples_after_trigger > samples_to_acquire) {
+      samples_after_trigger = samples_to_acquire;
+    }
+    break;
+
+  case SUMP_DIV: {
+    uint32_t period;
+
+    /*
+     * Read the 24-bits period value and rescale from SUMP's
+     * own 100MHz frequency range to the internal 16MIPs
+     * range.
+     */
+    period = (((((uint32_t)command[3] << 16) + ((uint32_t)command[2] << 8) +
+                (uint32_t)command[1]) + 1) * 4) / 25;
+
+    /* Do not go faster than advertised. */
+    if (period < (FCY / BP_SUMP_MAXIMUM_SAMPLE_RATE)) {
+      period = FCY / BP_SUMP_MAXIMUM_SAMPLE_RATE;
+    }
+    sample_period = period;
 
+    /*
+     * Set timer period.  The timer runs freely during captures, so a match
+     * every period cycles needs no allowance for the loop overhead.
+     */
+    PR5 = HI16(period - 1);
+    PR4 = LO16(period - 1);
+
+    break;
+  }
+  }
+}
+
+void sump_send_metadata(void) {
+  bp_write_buffer(SUMP_METADATA, sizeof(SUMP_METADATA));
+
+  /* Firmware version. */
+  user_serial_transmit_character(SUMP_METADATA_ANCILLARY_VERSION);
+  bp_write_string(BP_FIRMWARE_STRING);
+  user_serial_transmit_character('\0');
+
+  user_serial_transmit_character(SUMP_METADATA_END);
+}
+
+bool sump_handle_flow_control(uint8_t input_byte) {
+  for (;;) {
+    switch (input_byte) {
+    case SUMP_RESET:
+      return false;
+
+    case SUMP_XOFF:
+      /* Wait for the next byte before resuming. */
       break;
 
-    case SUMP_FLAGS:
-      /* @TODO: Fill this? */
+    default:
+      return true;
+    }
+
+    while (!user_serial_ready_to_read()) {
+    }
+    input_byte = user_serial_read_byte();
+  }
+}
+
+bool sump_capture_rle(const bool pre_trigger, const size_t samples_to_capture,
+                      size_t *end_offset, bool *late) {
+  sump_rle_state_t state;
+  sump_rle_state_t next;
+  uint8_t entries[SUMP_RLE_MAXIMUM_ENTRIES];
+  uint8_t count;
+  uint8_t index;
+  size_t offset;
+  size_t written;
+  uint16_t ticks;
+  uint8_t sample;
+  bool triggered;
+
+  offset = 0;
+  written = 0;
+  ticks = 0;
+  triggered = !pre_trigger;
+  *late = false;
+
+  /* Store the first sample as-is. */
+  count = sump_rle_start(&state, SUMP_READ_PROBES() & ~SUMP_RLE_COUNT_FLAG,
+                         entries);
+
+  for (;;) {
+    for (index = 0; index < count; index++) {
+      bus_pirate_configuration.terminal_input[offset] = entries[index];
+      offset = (offset + 1) & (BP_SUMP_SAMPLE_MEMORY_SIZE - 1);
+    }
+    if (triggered) {
+      written += count;
+    }
+
+    /* Give up if the period already elapsed, the time base would be off. */
+    if (IFS1bits.T5IF == ON) {
+      *late = true;
       break;
+    }
 
-    /* Read requested samples buffer size. */
-    case SUMP_CNT:
-      samples_to_acquire =
-          (((command_buffer.bytes[2] << 8) + command_buffer.bytes[1]) + 1) * 4;
+    /* Wait for timer4 interrupt to trigger. */
+    while (IFS1bits.T5IF == OFF) {
+    }
 
-      /* Clamp sample counter if more bytes are requested. */
-      if (samples_to_acquire > BP_SUMP_SAMPLE_MEMORY_SIZE) {
-        samples_to_acquire = BP_SUMP_SAMPLE_MEMORY_SIZE;
+    /* Clear timer #4 interrupt flag. */
+    IFS1bits.T5IF = OFF;
+
+    sample = SUMP_READ_PROBES() & ~SUMP_RLE_COUNT_FLAG;
+
+    if (!triggered) {
+      triggered = SUMP_TRIGGER_MATCH(sample);
+
+      /* Give commands a chance every now and then. */
+      if ((++ticks == 0) && user_serial_ready_to_read()) {
+        return false;
       }
+    }
+
+    /*
+     * Only take the sample if its entries, and the count of the run left in
+     * progress, still fit.
+     */
+    next = state;
+    count = sump_rle_encode(&next, sample, entries);
+    if (triggered &&
+        (written + count + sump_rle_pending(&next) > samples_to_capture)) {
       break;
+    }
+    state = next;
+  }
 
-    case SUMP_DIV: {
-      uint32_t period;
-
-      /*
-       * Read the 24-bits period value and rescale from SUMP's
-       * own 100MHz frequency range to the internal 16MIPs
-       * range.
-       */
-      period = (((((uint32_t)command_buffer.bytes[3] << 16) +
-                  ((uint32_t)command_buffer.bytes[2] << 8) +
-                  (uint32_t)command_buffer.bytes[1]) + 1) * 4) / 25;
-
-      /* Round down if needed. */
-      if (period > 0x10) {
-        period -= 0x10;
-      } else {
-        period = 1;
-      }
+  /* Close the run still in progress, there is always room left for it. */
+  if (sump_rle_finish(&state, entries) > 0) {
+    bus_pirate_configuration.terminal_input[offset] = entries[0];
+    offset = (offset + 1) & (BP_SUMP_SAMPLE_MEMORY_SIZE - 1);
+  }
 
-      /* Set timer period. */
-      PR5 = HI16(period);
-      PR4 = LO16(period);
+  *end_offset = offset;
+  return true;
+}
 
-      break;
+bool sump_trigger_enabled(void) {
+  size_t index;
+
+  for (index = 0; index < SUMP_TRIGGER_STAGES; index++) {
+    if (trigger_stages[index].mask != 0) {
+      return true;
     }
+  }
+
+  return false;
+}
+
+void sump_trigger_arm(void) {
+  const sump_trigger_stage_t *stage;
+  size_t index;
+  uint8_t stages;
+
+  stages = 0;
+  stage = NULL;
+  for (index = 0; index < SUMP_TRIGGER_STAGES; index++) {
+    trigger_stages[index].history = 0;
+    if (trigger_stages[index].mask != 0) {
+      stage = &trigger_stages[index];
+      stages++;
     }
+  }
 
-    command_processor_state = RX_COMMAND_IDLE;
-    break;
+  trigger_level = 0;
+  trigger_countdown = 0;
+
+  /* A lone immediate parallel start stage can be matched inline. */
+  trigger_simple = (stages == 1) && (stage->level == 0) && !stage->serial &&
+                   stage->start && (stage->delay == 0) &&
+                   ((stage->mask & ~(uint32_t)0xFF) == 0);
+  if (trigger_simple) {
+    trigger_simple_mask = stage->mask;
+    trigger_simple_value = stage->value;
+  }
+}
+
+bool sump_trigger_check(const uint8_t sample) {
+  sump_trigger_stage_t *stage;
+  uint32_t value;
+  size_t index;
+
+  /* A start stage already matched, wait for its delay to elapse. */
+  if (trigger_countdown > 0) {
+    return --trigger_countdown == 0;
+  }
+
+  for (index = 0; index < SUMP_TRIGGER_STAGES; index++) {
+    stage = &trigger_stages[index];
+
+    if (stage->mask == 0) {
+      continue;
+    }
+
+    if (stage->serial) {
+      stage->history = (stage->history << 1) | ((sample >> stage->channel) & 1);
+      value = stage->history;
+    } else {
+      value = sample;
+    }
+
+    if ((stage->level > trigger_level) ||
+        (((value ^ stage->value) & stage->mask) != 0)) {
+      continue;
+    }
+
+    if (stage->start) {
+      if (stage->delay == 0) {
+        return true;
+      }
+
+      trigger_countdown = stage->delay;
+      return false;
+    }
+
+    /* Move on to the next level. */
+    if (trigger_level <= stage->level) {
+      trigger_level = stage->level + 1;
+    }
   }
 
   return false;
 }
 
+sump_fixed_rate_capture_t sump_fixed_rate_capture(void) {
+#if defined(BP_SUMP_PACKED_SAMPLES) || defined(BP_SUMP_SOFT_WIRED_PROBES)
+  /* Fixed rate loops store one plain shifted port read per byte. */
+  return NULL;
+#else
+  switch (sample_period) {
+  case FCY / 4000000UL:
+    return sump_capture_4mhz;
+
+  case FCY / 2000000UL:
+    return sump_capture_2mhz;
+
+  case FCY / 1000000UL:
+    return sump_capture_1mhz;
+
+  default:
+    return NULL;
+  }
+#endif /* BP_SUMP_PACKED_SAMPLES || BP_SUMP_SOFT_WIRED_PROBES */
+}
+
+void sump_start_streaming(void) {
+  /* Turn the LED on. */
+  BP_LEDMODE = ON;
+
+  /* Stop timer #4. */
+  T4CON = 0;
+
+  /* Clamp the sampling period to what the interrupt handler can sustain. */
+  if (sample_period < BP_SUMP_STREAM_MINIMUM_PERIOD) {
+    PR5 = HI16(BP_SUMP_STREAM_MINIMUM_PERIOD - 1);
+    PR4 = LO16(BP_SUMP_STREAM_MINIMUM_PERIOD - 1);
+  }
+
+  /* Clear timer #4 and #5 counters. */
+  TMR5HLD = 0;
+  TMR4 = 0;
+
+  /* Timer #4 counter will be 32 bits wide. */
+  T4CONbits.T32 = ON;
+
+  /* Empty the ring buffer. */
+  stream_head = 0;
+  stream_tail = 0;
+  stream_overrun = false;
+
+  /*
+   * Sample on timer #5 interrupts, at a priority above the USB stack so that
+   * transfers do not introduce sampling jitter.
+   */
+  IFS1bits.T5IF = OFF;
+  IPC7bits.T5IP = 5;
+  IEC1bits.T5IE = ON;
+
+  sampler_state = SAMPLER_STREAMING;
+
+  /* Start timer #4. */
+  T4CONbits.TON = ON;
+}
+
+void sump_stop_streaming(void) {
+  /* Stop timer #4 and its interrupts. */
+  T4CON = 0;
+  IEC1bits.T5IE = OFF;
+  IFS1bits.T5IF = OFF;
+
+  /* Switch LED off. */
+  BP_LEDMODE = OFF;
+
+  sampler_state = SAMPLER_IDLE;
+}
+
+void __attribute__((interrupt, no_auto_psv)) _T5Interrupt(void) {
+  uint8_t sample;
+  uint16_t room;
+  uint16_t needed;
+
+  sample = SUMP_READ_PROBES();
+  room = (stream_tail - stream_head - 1) & (BP_SUMP_SAMPLE_MEMORY_SIZE - 1);
+
+  /* The sample, escaped if needed, preceded by a pending overrun marker. */
+  needed = (sample == SUMP_STREAM_ESCAPE) ? 2 : 1;
+  if (stream_overrun) {
+    needed += 2;
+  }
+
+  if (needed > room) {
+    /* The buffer is full, drop the sample. */
+    stream_overrun = true;
+  } else {
+    if (stream_overrun) {
+      SUMP_STREAM_PUSH(SUMP_STREAM_ESCAPE);
+      SUMP_STREAM_PUSH(SUMP_STREAM_OVERRUN);
+      stream_overrun = false;
+    }
+    if (sample == SUMP_STREAM_ESCAPE) {
+      SUMP_STREAM_PUSH(SUMP_STREAM_ESCAPE);
+    }
+    SUMP_STREAM_PUSH(sample);
+  }
+
+  IFS1bits.T5IF = OFF;
+}
+
 bool sump_acquire_samples(void) {
   switch (sampler_state) {
 
+  /* Drain one streamed sample, if any is available. */
+  case SAMPLER_STREAMING:
+    if (stream_tail != stream_head) {
+      user_serial_transmit_character(
+          bus_pirate_configuration.terminal_input[stream_tail]);
+      stream_tail = (stream_tail + 1) & (BP_SUMP_SAMPLE_MEMORY_SIZE - 1);
+    }
+    break;
+
   /* Can start sampling. */
   case SAMPLER_ARMED: {
     size_t offset;
+    size_t counter;
+    size_t samples_to_capture;
+    bool pre_trigger;
+    sump_fixed_rate_capture_t fixed_rate_capture;
+    uint16_t ticks;
+    uint8_t sample;
+    bool late;
+    uint8_t pending __attribute__((unused));
 
-    /* Skip if no interrupt and no trigger set. */
-    if (!IFS1bits.CNIF && CNEN2) {
-      break;
-    }
+    /*
+     * When a trigger is set, samples are taken all along while waiting for
+     * it to fire, so that the read count can include pre-trigger samples.
+     * Otherwise the whole read count is taken right away.
+     */
+    pre_trigger = sump_trigger_enabled();
+    samples_to_capture =
+        pre_trigger ? samples_after_trigger : samples_to_acquire;
 
     /* Take samples. */
 
+    offset = 0;
+    late = false;
+
     /* Start timer #4. */
     T4CONbits.TON = ON;
 
     /* Clear timer #4 interrupt flag. */
     IFS1bits.T5IF = OFF;
 
-    /* Capture samples into the terminal buffer. */
-    for (offset = 0; offset < samples_to_acquire; offset++) {
-      bus_pirate_configuration.terminal_input[offset] = PORTB >> 6;
+    /*
+     * Fixed rate loops take plain captures, and also triggered or RLE ones
+     * at rates the timer paced loops cannot keep up with.  In that case a
+     * simple trigger is polled first and the whole read count is taken after
+     * it fires, and RLE captures are stored as plain samples.
+     */
+    fixed_rate_capture = sump_fixed_rate_capture();
+    if ((rle_enabled || pre_trigger) &&
+        ((sample_period >= BP_SUMP_TIMED_MINIMUM_PERIOD) ||
+         (pre_trigger && !trigger_simple))) {
+      fixed_rate_capture = NULL;
+    }
 
-      /* Wait for timer4 interrupt to trigger. */
-      while (IFS1bits.T5IF == OFF) {
+    if (fixed_rate_capture != NULL) {
+      /* Samples are taken at fixed instruction counts, no timer needed. */
+      T4CONbits.TON = OFF;
+
+      if (pre_trigger) {
+        ticks = 0;
+        while (!SUMP_TRIGGER_MATCH(SUMP_READ_PROBES())) {
+          /* Give commands a chance every now and then. */
+          if ((++ticks == 0) && user_serial_ready_to_read()) {
+            return false;
+          }
+        }
+        samples_to_capture = samples_to_acquire;
       }
 
-      /* Clear timer #4 interrupt flag. */
-      IFS1bits.T5IF = OFF;
-    }
+      fixed_rate_capture(bus_pirate_configuration.terminal_input,
+                         samples_to_capture, &BP_SUMP_PROBES_PORT,
+                         BP_SUMP_PROBES_SHIFT);
+      offset = samples_to_capture & (BP_SUMP_SAMPLE_CAPACITY - 1);
+
+      /* Plain samples are valid RLE entries as long as none looks a count. */
+      if (rle_enabled) {
+        for (counter = 0; counter < samples_to_capture; counter++) {
+          bus_pirate_configuration.terminal_input[counter] &=
+              ~SUMP_RLE_COUNT_FLAG;
+        }
+      }
+    } else if (rle_enabled) {
+      if (!sump_capture_rle(pre_trigger, samples_to_capture, &offset,
+                            &late)) {
+        T4CONbits.TON = OFF;
+        return false;
+      }
+    } else {
+      /* Capture pre-trigger samples until the trigger fires. */
+      if (pre_trigger) {
+        for (;;) {
+          sample = SUMP_READ_PROBES();
+          SUMP_STORE_SAMPLE(offset, pending, sample);
+          offset = (offset + 1) & (BP_SUMP_SAMPLE_CAPACITY - 1);
+
+          /* Give commands a chance once per buffer wrap. */
+          if ((offset == 0) && user_serial_ready_to_read()) {
+            T4CONbits.TON = OFF;
+            return false;
+          }
+
+          /* Give up if the period already elapsed, see below. */
+          if (IFS1bits.T5IF == ON) {
+            late = true;
+            break;
+          }
+
+          /* Wait for timer4 interrupt to trigger. */
+          while (IFS1bits.T5IF == OFF) {
+          }
+
+          /* Clear timer #4 interrupt flag. */
+          IFS1bits.T5IF = OFF;
+
+          if (SUMP_TRIGGER_MATCH(sample)) {
+            break;
+          }
+        }
+      }
+
+      /* Capture samples into the terminal buffer. */
+      for (counter = 0; !late && (counter < samples_to_capture); counter++) {
+        SUMP_STORE_SAMPLE(offset, pending, SUMP_READ_PROBES());
+        offset = (offset + 1) & (BP_SUMP_SAMPLE_CAPACITY - 1);
+
+        /* Give up if the period already elapsed, see below. */
+        if (IFS1bits.T5IF == ON) {
+          late = true;
+          break;
+        }
+
+        /* Wait for timer4 interrupt to trigger. */
+        while (IFS1bits.T5IF == OFF) {
+        }
 
-    /* Disable change notification for pins 16 to 31. */
-    CNEN2 = 0;
+        /* Clear timer #4 interrupt flag. */
+        IFS1bits.T5IF = OFF;
+      }
+
+      SUMP_FLUSH_SAMPLE(offset, pending);
+    }
 
     /* Stop timer #4. */
     T4CON = OFF;
 
-    /* Write captured samples out. */
-    for (offset = samples_to_acquire; offset > 0; offset--) {
-      user_serial_transmit_character(bus_pirate_configuration.terminal_input[offset - 1]);
+    /*
+     * A sample was taken after its period had already elapsed, the rate was
+     * too high for the loop (usually because of the trigger stages).  Sending
+     * the samples would silently stretch the time base, so send an all-low
+     * capture instead: the client gets the full read count rather than
+     * waiting forever, and can retry at a lower rate.
+     */
+    if (late) {
+      memset(bus_pirate_configuration.terminal_input, 0,
+             BP_SUMP_SAMPLE_MEMORY_SIZE);
+    }
+
+    /* Write captured samples out, most recent first. */
+    for (counter = 0; counter < samples_to_acquire; counter++) {
+      /* Honour flow control requests from the host. */
+      if (user_serial_ready_to_read() &&
+          !sump_handle_flow_control(user_serial_read_byte())) {
+        break;
+      }
+
+      offset = (offset - 1) & (BP_SUMP_SAMPLE_CAPACITY - 1);
+      user_serial_transmit_character(SUMP_LOAD_SAMPLE(offset));
     }
 
     /* Reset the analyzer state. */
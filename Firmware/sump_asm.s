@@ -0,0 +1,140 @@
+;
+; sump_asm.s
+;
+; Fixed rate capture loops for the SUMP logic analyzer mode.
+;
+; Written and maintained by the Bus Pirate project.
+;
+; To the extent possible under law, the project has waived all copyright and
+; related or neighboring rights to Bus Pirate.  This work is published from
+; United States.
+;
+; For details see: http://creativecommons.org/publicdomain/zero/1.0/
+;
+; This program is distributed in the hope that it will be useful, but WITHOUT
+; ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+; FOR A PARTICULAR PURPOSE.
+;
+
+.ifdef __PIC24FJ256GB106__
+	.equ __24FJ256GB106, 1
+	.include "p24FJ256GB106.inc"
+.endif ; __PIC24FJ256GB106__
+
+.ifdef __PIC24FJ64GA002__
+	.equ __24FJ64GA002, 1
+	.include "p24FJ64GA002.inc"
+.endif ; __PIC24FJ64GA002__
+
+;
+; All loops share the same prototype:
+;
+; void sump_capture_XXXX(uint8_t *buffer, uint16_t count,
+;                        volatile uint16_t *port, uint16_t shift)
+;
+; Parameters:
+;  w0 : destination buffer
+;  w1 : samples to take, must be a multiple of 4
+;  w2 : address of the PORTx register to sample
+;  w3 : how many bits the port value is shifted right before being stored
+;
+; Register usage:
+;
+;  w0     : destination pointer
+;  w1     : end of the destination buffer
+;  w4..w7 : samples being processed
+;
+; Each loop iteration takes exactly 16 cycles, and the port is read at fixed
+; offsets within it.  The loop ends on a pointer comparison rather than on a
+; counter, since the shift instructions would clobber the Z flag.  Interrupts
+; are masked for the whole capture, so that nothing disturbs the timing.
+;
+
+.macro CAPTURE_PROLOGUE
+		push	SR			; save interrupt priority level
+		mov	SR, w4			; IPL = 7
+		ior	#0x00E0, w4
+		mov	w4, SR
+		add	w0, w1, w1		; w1 = buffer + count
+.endm
+
+.macro CAPTURE_EPILOGUE
+		pop	SR			; restore interrupt priority level
+		return
+.endm
+
+	.text
+	.global _sump_capture_4mhz
+	.global _sump_capture_2mhz
+	.global _sump_capture_1mhz
+
+;
+; FCY / 4 (4MHz): four samples per iteration.
+;
+; The last sample of an iteration is stored by the next one, so the loop is
+; primed with a sample taken four cycles before the first iteration starts.
+; The very last sample taken is discarded.
+;
+
+_sump_capture_4mhz:
+		CAPTURE_PROLOGUE
+		mov	[w2], w7		; prime with the sample before A
+		nop
+		nop
+		nop
+1:
+		mov	[w2], w4		;  0: sample A
+		lsr	w7, w3, w7		;  1
+		mov.b	w7, [w0++]		;  2: store previous D
+		lsr	w4, w3, w4		;  3
+		mov	[w2], w5		;  4: sample B
+		mov.b	w4, [w0++]		;  5: store A
+		lsr	w5, w3, w5		;  6
+		mov.b	w5, [w0++]		;  7: store B
+		mov	[w2], w6		;  8: sample C
+		lsr	w6, w3, w6		;  9
+		mov.b	w6, [w0++]		; 10: store C
+		nop				; 11
+		mov	[w2], w7		; 12: sample D
+		cpseq	w0, w1			; 13
+		bra	1b			; 14, 15
+		CAPTURE_EPILOGUE
+
+;
+; FCY / 8 (2MHz): two samples per iteration.
+;
+
+_sump_capture_2mhz:
+		CAPTURE_PROLOGUE
+1:
+		mov	[w2], w4		;  0: sample A
+		lsr	w4, w3, w4		;  1
+		mov.b	w4, [w0++]		;  2: store A
+		repeat	#3			;  3
+		nop				;  4..7
+		mov	[w2], w5		;  8: sample B
+		lsr	w5, w3, w5		;  9
+		mov.b	w5, [w0++]		; 10: store B
+		nop				; 11
+		nop				; 12
+		cpseq	w0, w1			; 13
+		bra	1b			; 14, 15
+		CAPTURE_EPILOGUE
+
+;
+; FCY / 16 (1MHz): one sample per iteration.
+;
+
+_sump_capture_1mhz:
+		CAPTURE_PROLOGUE
+1:
+		mov	[w2], w4		;  0: sample
+		lsr	w4, w3, w4		;  1
+		mov.b	w4, [w0++]		;  2: store
+		repeat	#8			;  3
+		nop				;  4..12
+		cpseq	w0, w1			; 13
+		bra	1b			; 14, 15
+		CAPTURE_EPILOGUE
+
+	.end
@@ -0,0 +1,150 @@
+/*
+ * This file is part of the Bus Pirate project
+ * (http://code.google.com/p/the-bus-pirate/).
+ *
+ * Written and maintained by the Bus Pirate project.
+ *
+ * To the extent possible under law, the project has waived all copyright and
+ * related or neighboring rights to Bus Pirate.  This work is published from
+ * United States.
+ *
+ * For details see: http://creativecommons.org/publicdomain/zero/1.0/
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.
+ */
+
+/**
+ * @file sump_rle.h
+ *
+ * @brief SUMP run length encoder.
+ *
+ * Samples are stored as-is when they differ from the previous one.  A run of
+ * identical samples is stored as the first sample, followed by an entry with
+ * SUMP_RLE_COUNT_FLAG set and the number of further repetitions in the lower
+ * bits.  Runs longer than SUMP_RLE_MAXIMUM_RUN repetitions take more than one
+ * count entry.
+ *
+ * The encoder is kept free of hardware dependencies, and inline for the
+ * capture loop, so that it can be built and tested on the host.
+ */
+
+#ifndef BP_SUMP_RLE_H
+#define BP_SUMP_RLE_H
+
+#include <stdint.h>
+
+/**
+ * Entry flag marking a run length count in RLE captures.
+ *
+ * On boards with eight probes this takes the place of channel 7, as the SUMP
+ * protocol expects.
+ */
+#define SUMP_RLE_COUNT_FLAG 0x80
+
+/**
+ * Longest run a single RLE count entry can hold.
+ */
+#define SUMP_RLE_MAXIMUM_RUN 0x7F
+
+/**
+ * Most entries a single sample can produce: a run count and the sample.
+ */
+#define SUMP_RLE_MAXIMUM_ENTRIES 2
+
+/**
+ * Run length encoder state.
+ */
+typedef struct {
+
+  /** The last sample value stored. */
+  uint8_t previous;
+
+  /** How many times the last sample was repeated since being stored. */
+  uint8_t run;
+
+} sump_rle_state_t;
+
+/**
+ * Starts encoding with the given sample.
+ *
+ * @param[out] state the encoder state to initialise.
+ * @param[in] sample the first sample, without SUMP_RLE_COUNT_FLAG.
+ * @param[out] entries where to store the produced entry.
+ *
+ * @return how many entries were produced, always 1.
+ */
+static inline uint8_t sump_rle_start(sump_rle_state_t *state,
+                                     const uint8_t sample, uint8_t *entries) {
+  state->previous = sample;
+  state->run = 0;
+  entries[0] = sample;
+  return 1;
+}
+
+/**
+ * Adds a sample to the encoded stream.
+ *
+ * @param[in,out] state the encoder state.
+ * @param[in] sample the sample to add, without SUMP_RLE_COUNT_FLAG.
+ * @param[out] entries where to store the produced entries, room for
+ *             SUMP_RLE_MAXIMUM_ENTRIES is needed.
+ *
+ * @return how many entries were produced.
+ */
+static inline uint8_t sump_rle_encode(sump_rle_state_t *state,
+                                      const uint8_t sample, uint8_t *entries) {
+  uint8_t count;
+
+  if (sample == state->previous) {
+    /* Extend the current run, writing it out when a count entry is full. */
+    if (++state->run < SUMP_RLE_MAXIMUM_RUN) {
+      return 0;
+    }
+    entries[0] = SUMP_RLE_COUNT_FLAG | state->run;
+    state->run = 0;
+    return 1;
+  }
+
+  /* Close the previous run, if any, then store the new value. */
+  count = 0;
+  if (state->run > 0) {
+    entries[count++] = SUMP_RLE_COUNT_FLAG | state->run;
+    state->run = 0;
+  }
+  entries[count++] = sample;
+  state->previous = sample;
+  return count;
+}
+
+/**
+ * Returns how many entries finishing the stream would produce right now.
+ *
+ * @param[in] state the encoder state.
+ *
+ * @return 1 if a run is in progress, 0 otherwise.
+ */
+static inline uint8_t sump_rle_pending(const sump_rle_state_t *state) {
+  return (state->run > 0) ? 1 : 0;
+}
+
+/**
+ * Ends the encoded stream, writing out a run still in progress.
+ *
+ * @param[in,out] state the encoder state.
+ * @param[out] entries where to store the produced entry.
+ *
+ * @return how many entries were produced.
+ */
+static inline uint8_t sump_rle_finish(sump_rle_state_t *state,
+                                      uint8_t *entries) {
+  if (state->run == 0) {
+    return 0;
+  }
+  entries[0] = SUMP_RLE_COUNT_FLAG | state->run;
+  state->run = 0;
+  return 1;
+}
+
+#endif /* !BP_SUMP_RLE_H */
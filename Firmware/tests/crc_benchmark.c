@@ -0,0 +1,140 @@
+/*
+ * This file is part of the Bus Pirate project
+ * (http://code.google.com/p/the-bus-pirate/).
+ *
+ * Written and maintained by the Bus Pirate project.
+ *
+ * To the extent possible under law, the project has waived all copyright and
+ * related or neighboring rights to Bus Pirate.  This work is published from
+ * United States.
+ *
+ * For details see: http://creativecommons.org/publicdomain/zero/1.0/
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.
+ */
+
+/**
+ * @file crc_benchmark.c
+ *
+ * @brief Host microbenchmark for the CRC module.
+ *
+ * Compares the table-driven routines against plain bit-by-bit loops over a
+ * terminal buffer sized block.  Host figures only give the relative cost of
+ * the two approaches, absolute timings on the PIC24 are much lower.
+ */
+
+#include <stdio.h>
+#include <time.h>
+
+#include "../crc.h"
+
+/**
+ * @brief Size of the block to compute CRCs over, as the terminal buffer.
+ */
+#define BLOCK_SIZE 4096
+
+/**
+ * @brief How many times each routine goes over the block.
+ */
+#define ITERATIONS 2000
+
+static uint8_t block[BLOCK_SIZE];
+
+/**
+ * @brief Sink for results, so that the compiler keeps the loops.
+ */
+static volatile uint32_t sink;
+
+static uint8_t bitwise_crc8_maxim(uint8_t crc, const uint8_t *buffer,
+                                  size_t length) {
+  uint8_t bit;
+
+  while (length-- > 0) {
+    crc ^= *buffer++;
+    for (bit = 0; bit < 8; bit++) {
+      crc = (crc & 1) ? (crc >> 1) ^ 0x8C : crc >> 1;
+    }
+  }
+
+  return crc;
+}
+
+static uint16_t bitwise_crc16_ibm(uint16_t crc, const uint8_t *buffer,
+                                  size_t length) {
+  uint8_t bit;
+
+  while (length-- > 0) {
+    crc ^= *buffer++;
+    for (bit = 0; bit < 8; bit++) {
+      crc = (crc & 1) ? (crc >> 1) ^ 0xA001 : crc >> 1;
+    }
+  }
+
+  return crc;
+}
+
+static uint32_t bitwise_crc32(uint32_t crc, const uint8_t *buffer,
+                              size_t length) {
+  uint8_t bit;
+
+  crc = ~crc;
+  while (length-- > 0) {
+    crc ^= *buffer++;
+    for (bit = 0; bit < 8; bit++) {
+      crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320UL : crc >> 1;
+    }
+  }
+
+  return ~crc;
+}
+
+/**
+ * @brief Prints the throughput of the given number of processed bytes.
+ *
+ * @param[in] name the name of the routine.
+ * @param[in] start the clock value when the run started.
+ * @param[in] result the last value computed, to check both loops agree.
+ */
+static void report(const char *name, const clock_t start,
+                   const uint32_t result) {
+  double seconds;
+
+  seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+  printf("%-20s %8.1f MB/s  (0x%08lX)\n", name,
+         seconds > 0 ? (double)BLOCK_SIZE * ITERATIONS / seconds / 1e6 : 0.0,
+         (unsigned long)result);
+}
+
+#define RUN(name, call)                                                        \
+  do {                                                                         \
+    clock_t start;                                                             \
+    uint32_t result;                                                           \
+    int iteration;                                                             \
+                                                                               \
+    result = 0;                                                                \
+    start = clock();                                                           \
+    for (iteration = 0; iteration < ITERATIONS; iteration++) {                 \
+      result = (call);                                                         \
+      sink = result;                                                           \
+    }                                                                          \
+    report(name, start, result);                                               \
+  } while (0)
+
+int main(void) {
+  size_t index;
+
+  for (index = 0; index < BLOCK_SIZE; index++) {
+    block[index] = (uint8_t)(index * 31 + 7);
+  }
+
+  RUN("crc8_maxim", crc8_maxim(0, block, BLOCK_SIZE));
+  RUN("crc8 bitwise", bitwise_crc8_maxim(0, block, BLOCK_SIZE));
+  RUN("crc16_ibm", crc16_ibm(0, block, BLOCK_SIZE));
+  RUN("crc16 bitwise", bitwise_crc16_ibm(0, block, BLOCK_SIZE));
+  RUN("crc32", crc32(0, block, BLOCK_SIZE));
+  RUN("crc32 bitwise", bitwise_crc32(0, block, BLOCK_SIZE));
+
+  return 0;
+}
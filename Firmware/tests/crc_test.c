@@ -0,0 +1,151 @@
+/*
+ * This file is part of the Bus Pirate project
+ * (http://code.google.com/p/the-bus-pirate/).
+ *
+ * Written and maintained by the Bus Pirate project.
+ *
+ * To the extent possible under law, the project has waived all copyright and
+ * related or neighboring rights to Bus Pirate.  This work is published from
+ * United States.
+ *
+ * For details see: http://creativecommons.org/publicdomain/zero/1.0/
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.
+ */
+
+/**
+ * @file crc_test.c
+ *
+ * @brief Host unit tests for the CRC module.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "../crc.h"
+
+/**
+ * @brief Standard CRC check string.
+ */
+static const uint8_t CHECK_STRING[] = "123456789";
+
+/**
+ * @brief Length of the check string, without the terminator.
+ */
+#define CHECK_LENGTH (sizeof(CHECK_STRING) - 1)
+
+/**
+ * @brief Count of failed checks.
+ */
+static int failures = 0;
+
+#define EXPECT(condition, ...)                                                 \
+  do {                                                                         \
+    if (!(condition)) {                                                        \
+      printf("FAIL %s:%d: ", __FILE__, __LINE__);                              \
+      printf(__VA_ARGS__);                                                     \
+      printf("\n");                                                            \
+      failures++;                                                              \
+    }                                                                          \
+  } while (0)
+
+static void test_check_values(void) {
+  uint8_t crc8;
+  uint16_t crc16;
+  uint32_t crc32_value;
+
+  crc8 = crc8_maxim(0, CHECK_STRING, CHECK_LENGTH);
+  EXPECT(crc8 == 0xA1, "CRC8-Maxim is 0x%02X, expected 0xA1", crc8);
+
+  crc16 = crc16_ibm(0, CHECK_STRING, CHECK_LENGTH);
+  EXPECT(crc16 == 0xBB3D, "CRC16-IBM is 0x%04X, expected 0xBB3D", crc16);
+
+  crc32_value = crc32(0, CHECK_STRING, CHECK_LENGTH);
+  EXPECT(crc32_value == 0xCBF43926UL, "CRC32 is 0x%08lX, expected 0xCBF43926",
+         (unsigned long)crc32_value);
+}
+
+static void test_empty_buffer(void) {
+  EXPECT(crc8_maxim(0x5A, CHECK_STRING, 0) == 0x5A,
+         "CRC8-Maxim changed on empty input");
+  EXPECT(crc16_ibm(0x1234, CHECK_STRING, 0) == 0x1234,
+         "CRC16-IBM changed on empty input");
+  EXPECT(crc32(0xDEADBEEFUL, CHECK_STRING, 0) == 0xDEADBEEFUL,
+         "CRC32 changed on empty input");
+}
+
+static void test_chunked_feeding(void) {
+  size_t split;
+  size_t second;
+
+  /* Every single split point. */
+  for (split = 0; split <= CHECK_LENGTH; split++) {
+    EXPECT(crc8_maxim(crc8_maxim(0, CHECK_STRING, split), CHECK_STRING + split,
+                      CHECK_LENGTH - split) == 0xA1,
+           "CRC8-Maxim split at %zu", split);
+    EXPECT(crc16_ibm(crc16_ibm(0, CHECK_STRING, split), CHECK_STRING + split,
+                     CHECK_LENGTH - split) == 0xBB3D,
+           "CRC16-IBM split at %zu", split);
+    EXPECT(crc32(crc32(0, CHECK_STRING, split), CHECK_STRING + split,
+                 CHECK_LENGTH - split) == 0xCBF43926UL,
+           "CRC32 split at %zu", split);
+  }
+
+  /* Three chunks, with every pair of split points. */
+  for (split = 0; split <= CHECK_LENGTH; split++) {
+    for (second = split; second <= CHECK_LENGTH; second++) {
+      uint32_t crc32_value;
+
+      crc32_value = crc32(0, CHECK_STRING, split);
+      crc32_value = crc32(crc32_value, CHECK_STRING + split, second - split);
+      crc32_value =
+          crc32(crc32_value, CHECK_STRING + second, CHECK_LENGTH - second);
+      EXPECT(crc32_value == 0xCBF43926UL, "CRC32 split at %zu and %zu", split,
+             second);
+    }
+  }
+}
+
+static void test_crc8_update(void) {
+  uint8_t crc;
+  size_t index;
+
+  crc = 0;
+  for (index = 0; index < CHECK_LENGTH; index++) {
+    crc = crc8_maxim_update(crc, CHECK_STRING[index]);
+  }
+  EXPECT(crc == 0xA1, "byte-wise CRC8-Maxim is 0x%02X, expected 0xA1", crc);
+}
+
+static void test_crc8_residue(void) {
+  /* The ROM number example from Maxim AN27, CRC byte last. */
+  static const uint8_t ROM[] = {0x02, 0x1C, 0xB8, 0x01, 0x00, 0x00, 0x00, 0xA2};
+  uint8_t buffer[CHECK_LENGTH + 1];
+
+  EXPECT(crc8_maxim(0, ROM, sizeof(ROM) - 1) == ROM[sizeof(ROM) - 1],
+         "ROM CRC byte mismatch");
+  EXPECT(crc8_maxim(0, ROM, sizeof(ROM)) == 0, "ROM residue is not zero");
+
+  memcpy(buffer, CHECK_STRING, CHECK_LENGTH);
+  buffer[CHECK_LENGTH] = 0xA1;
+  EXPECT(crc8_maxim(0, buffer, sizeof(buffer)) == 0,
+         "check string residue is not zero");
+}
+
+int main(void) {
+  test_check_values();
+  test_empty_buffer();
+  test_chunked_feeding();
+  test_crc8_update();
+  test_crc8_residue();
+
+  if (failures != 0) {
+    printf("crc_test: %d failure(s)\n", failures);
+    return 1;
+  }
+
+  printf("crc_test: all tests passed\n");
+  return 0;
+}
@@ -0,0 +1,255 @@
+/*
+ * This file is part of the Bus Pirate project
+ * (http://code.google.com/p/the-bus-pirate/).
+ *
+ * Written and maintained by the Bus Pirate project.
+ *
+ * To the extent possible under law, the project has waived all copyright and
+ * related or neighboring rights to Bus Pirate.  This work is published from
+ * United States.
+ *
+ * For details see: http://creativecommons.org/publicdomain/zero/1.0/
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.
+ */
+
+/**
+ * @file sump_rle_test.c
+ *
+ * @brief Host tests for the SUMP run length encoder.
+ *
+ * Samples are encoded the way sump_capture_rle() does, including its entry
+ * budget, then decoded the way SUMP clients do and compared.
+ */
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../sump_rle.h"
+
+/**
+ * @brief Largest sample stream used by the tests.
+ */
+#define MAXIMUM_SAMPLES 65536
+
+/**
+ * @brief Entry budget, as the terminal buffer.
+ */
+#define MAXIMUM_ENTRIES 4096
+
+/**
+ * @brief Count of failed checks.
+ */
+static int failures = 0;
+
+#define EXPECT(condition, ...)                                                 \
+  do {                                                                         \
+    if (!(condition)) {                                                        \
+      printf("FAIL %s:%d: ", __FILE__, __LINE__);                              \
+      printf(__VA_ARGS__);                                                     \
+      printf("\n");                                                            \
+      failures++;                                                              \
+    }                                                                          \
+  } while (0)
+
+static uint8_t samples[MAXIMUM_SAMPLES];
+static uint8_t entries[MAXIMUM_ENTRIES];
+static uint8_t decoded[MAXIMUM_SAMPLES + SUMP_RLE_MAXIMUM_RUN];
+
+/**
+ * @brief Encodes samples until they run out or the entry budget is spent.
+ *
+ * Mirrors the loop in sump_capture_rle(): a sample is only taken if its
+ * entries and the count of the run it leaves in progress still fit, and the
+ * run in progress is written out at the end.
+ *
+ * @param[in] count how many samples are available.
+ * @param[in] budget how many entries can be written.
+ * @param[out] taken how many samples were encoded.
+ *
+ * @return how many entries were written.
+ */
+static size_t encode(const size_t count, const size_t budget, size_t *taken) {
+  sump_rle_state_t state;
+  sump_rle_state_t next;
+  uint8_t produced[SUMP_RLE_MAXIMUM_ENTRIES];
+  uint8_t produced_count;
+  size_t written;
+  size_t index;
+
+  written = sump_rle_start(&state, samples[0], entries);
+  for (index = 1; index < count; index++) {
+    next = state;
+    produced_count = sump_rle_encode(&next, samples[index], produced);
+    if (written + produced_count + sump_rle_pending(&next) > budget) {
+      break;
+    }
+    state = next;
+    memcpy(entries + written, produced, produced_count);
+    written += produced_count;
+  }
+  *taken = index;
+
+  written += sump_rle_finish(&state, entries + written);
+  return written;
+}
+
+/**
+ * @brief Decodes entries the way SUMP clients do.
+ *
+ * @param[in] count how many entries to decode.
+ *
+ * @return how many samples were decoded, or 0 if the stream is malformed.
+ */
+static size_t decode(const size_t count) {
+  size_t written;
+  size_t index;
+  uint8_t repeat;
+
+  written = 0;
+  for (index = 0; index < count; index++) {
+    if (entries[index] & SUMP_RLE_COUNT_FLAG) {
+      /* A count must follow a value. */
+      if (written == 0) {
+        return 0;
+      }
+      for (repeat = 0; repeat < (entries[index] & SUMP_RLE_MAXIMUM_RUN);
+           repeat++) {
+        decoded[written] = decoded[written - 1];
+        written++;
+      }
+    } else {
+      decoded[written++] = entries[index];
+    }
+  }
+
+  return written;
+}
+
+/**
+ * @brief Encodes and decodes samples, checking the round trip.
+ *
+ * @param[in] name the name of the test pattern.
+ * @param[in] count how many samples are available.
+ * @param[in] budget how many entries can be written.
+ */
+static void round_trip(const char *name, const size_t count,
+                       const size_t budget) {
+  size_t written;
+  size_t taken;
+  size_t length;
+
+  written = encode(count, budget, &taken);
+  EXPECT(written <= budget, "%s: %zu entries written, budget is %zu", name,
+         written, budget);
+
+  length = decode(written);
+  EXPECT(length == taken, "%s: %zu samples decoded, %zu encoded", name,
+         length, taken);
+  EXPECT(memcmp(decoded, samples, taken) == 0, "%s: decoded samples differ",
+         name);
+}
+
+static void test_constant(void) {
+  memset(samples, 0x15, MAXIMUM_SAMPLES);
+
+  /* The whole run fits, and its last count must not be lost. */
+  round_trip("constant, short", 10, MAXIMUM_ENTRIES);
+  round_trip("constant, one full count", SUMP_RLE_MAXIMUM_RUN + 1,
+             MAXIMUM_ENTRIES);
+  round_trip("constant, count boundary", SUMP_RLE_MAXIMUM_RUN + 2,
+             MAXIMUM_ENTRIES);
+  round_trip("constant, long", MAXIMUM_SAMPLES, MAXIMUM_ENTRIES);
+
+  /* Budget exhausted in the middle of a run. */
+  round_trip("constant, tight budget", MAXIMUM_SAMPLES, 3);
+}
+
+static void test_alternating(void) {
+  size_t index;
+
+  for (index = 0; index < MAXIMUM_SAMPLES; index++) {
+    samples[index] = (index & 1) ? 0x01 : 0x02;
+  }
+
+  round_trip("alternating", MAXIMUM_SAMPLES, MAXIMUM_ENTRIES);
+  round_trip("alternating, odd budget", MAXIMUM_SAMPLES, 7);
+}
+
+static void test_bursts(void) {
+  size_t index;
+  size_t idle;
+
+  /* Long idle stretches with short bursts, as a typical bus. */
+  index = 0;
+  idle = 1;
+  while (index < MAXIMUM_SAMPLES) {
+    size_t length;
+
+    for (length = 0; (length < idle) && (index < MAXIMUM_SAMPLES); length++) {
+      samples[index++] = 0x1F;
+    }
+    for (length = 0; (length < 16) && (index < MAXIMUM_SAMPLES); length++) {
+      samples[index++] = (uint8_t)((length * 5) & 0x1F);
+    }
+    idle = (idle * 3 + 7) % 1000;
+  }
+
+  round_trip("bursts", MAXIMUM_SAMPLES, MAXIMUM_ENTRIES);
+}
+
+static void test_random(void) {
+  size_t index;
+  size_t budget;
+
+  srand(1);
+  for (budget = 1; budget <= 64; budget++) {
+    for (index = 0; index < 1024; index++) {
+      /* Mostly repeated values, to exercise runs of every length. */
+      samples[index] = ((rand() % 8) == 0) ? (uint8_t)(rand() & 0x7F)
+                       : (index > 0)       ? samples[index - 1]
+                                           : 0;
+    }
+    round_trip("random", 1024, budget);
+  }
+}
+
+static void test_encoding(void) {
+  size_t written;
+  size_t taken;
+
+  /* A, A, A, B is stored as A, count 2, B. */
+  samples[0] = 0x0A;
+  samples[1] = 0x0A;
+  samples[2] = 0x0A;
+  samples[3] = 0x0B;
+  written = encode(4, MAXIMUM_ENTRIES, &taken);
+  EXPECT((written == 3) && (entries[0] == 0x0A) &&
+             (entries[1] == (SUMP_RLE_COUNT_FLAG | 2)) && (entries[2] == 0x0B),
+         "A A A B encoded as %zu entries", written);
+
+  /* A trailing run gets its count. */
+  written = encode(3, MAXIMUM_ENTRIES, &taken);
+  EXPECT((written == 2) && (entries[1] == (SUMP_RLE_COUNT_FLAG | 2)),
+         "trailing run count missing");
+}
+
+int main(void) {
+  test_encoding();
+  test_constant();
+  test_alternating();
+  test_bursts();
+  test_random();
+
+  if (failures != 0) {
+    printf("sump_rle_test: %d failure(s)\n", failures);
+    return 1;
+  }
+
+  printf("sump_rle_test: all tests passed\n");
+  return 0;
+}
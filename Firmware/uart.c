@@ -35,6 +35,18 @@ extern bool command_error;
 #define UART_MACRO_RAW_UART 2
 #define UART_MACRO_BRIDGE_WITH_FLOW_CONTROL 3
 #define UART_MACRO_AUTO_BAUD_RATE_DETECTION 4
+#define UART_MACRO_AUTO_BAUD_RATE_LOCK 5
+
+/**
+ * How many signal edges to timestamp on the RX pin when locking the baud rate.
+ */
+#define UART_AUTO_BAUD_LOCK_EDGES_COUNT 64
+
+/**
+ * Longest bit time the baud rate generator can match when locking the baud
+ * rate, in FCY ticks (U2BRG = 0xFFFF with BRGH set).
+ */
+#define UART_AUTO_BAUD_MAXIMUM_BIT_TIME ((0xFFFFUL + 1) * 4)
 
 typedef struct {
   uint8_t databits_parity : 2;
@@ -85,6 +97,36 @@ static uint32_t uart_get_closest_common_rate(const uint32_t baud_rate);
  */
 static uint32_t uart_get_baud_rate(const bool quiet);
 
+/**
+ * Measures the shortest interval between two edges on the RX pin.
+ *
+ * Edges are timestamped by the input capture units at FCY resolution, so the
+ * shortest interval seen over enough edges is exactly one bit time.  Sending
+ * a byte on the user-facing serial port stops the measurement early.
+ *
+ * @param[in] edges how many edges to timestamp at most.
+ *
+ * @return the shortest interval found, in FCY ticks, or 0 if the measurement
+ * was stopped before two edges were seen.
+ */
+static uint32_t uart_measure_bit_time(const uint16_t edges);
+
+/**
+ * Measures the bit time on the RX pin and sets up UART #2 with the baud rate
+ * generator value matching it.
+ *
+ * UART #2 must be disabled before calling this function.  On exit it is set up
+ * again, either with the new baud rate generator value or with the previous
+ * one if the measurement failed, but it is left disabled.
+ *
+ * @param[in] quiet true if no messages should be printed on the console, false
+ * if no verbose reporting is needed.
+ *
+ * @return the measured baud rate, or 0 if no measurement could be performed.
+ * On success the baud rate generator value in use can be read from U2BRG.
+ */
+static uint32_t uart_lock_baud_rate(const bool quiet);
+
 uint16_t uart_read(void) {
   if (uart2_rx_ready()) {
     uint16_t character;
@@ -343,6 +385,9 @@ void uart_run_macro(const uint16_t macro) {
     /* Clear overrun flag. */
     U2STAbits.OERR = OFF;
 
+    /* Received bytes bypass the transmission queue, flush it first. */
+    user_serial_wait_transmission_done();
+
     for (;;) {
 #ifdef BUSPIRATEV4
       if (BP_BUTTON_ISDOWN()) {
@@ -390,6 +435,10 @@ void uart_run_macro(const uint16_t macro) {
     MSG_ANY_KEY_TO_EXIT_PROMPT;
 
     U2STAbits.OERR = OFF;
+
+    /* Received bytes bypass the transmission queue, flush it first. */
+    user_serial_wait_transmission_done();
+
     for (;;) {
 #ifdef BUSPIRATEV4
       if (BP_BUTTON_ISDOWN()) {
@@ -425,6 +474,20 @@ void uart_run_macro(const uint16_t macro) {
 #endif /* BUSPIRATEV3 */
     break;
 
+  case UART_MACRO_AUTO_BAUD_RATE_LOCK:
+    uart2_disable();
+    if (uart_lock_baud_rate(false) > 0) {
+      /* The custom BRG speed slot reads its value back from U2BRG. */
+      mode_configuration.speed = 9;
+    }
+    uart2_enable();
+#ifdef BUSPIRATEV3
+    if (U2BRG < U1BRG) {
+      MSG_UART_POSSIBLE_OVERFLOW;
+    }
+#endif /* BUSPIRATEV3 */
+    break;
+
   default:
     MSG_UNKNOWN_MACRO_ERROR;
     break;
@@ -681,6 +744,226 @@ uint32_t uart_get_baud_rate(const bool quiet) {
   return bit_sample;
 }
 
+#if defined(BUSPIRATEV4)
+#define UART_IC1_BUFFER_NOT_EMPTY IC1CON1bits.ICBNE
+#else
+#define UART_IC1_BUFFER_NOT_EMPTY IC1CONbits.ICBNE
+#endif /* BUSPIRATEV4 */
+
+uint32_t uart_measure_bit_time(const uint16_t edges) {
+  uint32_t previous_timestamp;
+  uint32_t current_timestamp;
+  uint32_t shortest_interval;
+  uint16_t index;
+
+  BP_MISO_DIR = INPUT;
+
+  /* Both input capture units listen on the RX pin. */
+  RPINR7bits.IC1R = BP_MISO_RPIN;
+  RPINR7bits.IC2R = BP_MISO_RPIN;
+
+#if defined(BUSPIRATEV4)
+
+  /* Setup timer 4 as a free running 32 bits timer. */
+  T4CON = 0x0000;
+  PR5 = 0xFFFF;
+  PR4 = 0xFFFF;
+  TMR5HLD = 0x0000;
+  TMR4 = 0x0000;
+
+  /*
+   * T4CON
+   *
+   * MSB
+   * 1-0------001-0-
+   * | |      ||| |
+   * | |      ||| +--- TCS:   Internal clock (FOSC/2).
+   * | |      ||+----- T32:   TIMER4 is bound with TIMER5 for 32 bit mode.
+   * | |      ++------ TCKPS: 1:1 Prescaler.
+   * | +-------------- TSIDL: Continue module operation in idle mode.
+   * +---------------- TON:   Timer ON.
+   */
+  T4CON = (ON << _T4CON_TON_POSITION) | (ON << _T4CON_T32_POSITION);
+
+  /*
+   * IC1CON1
+   *
+   * MSB
+   * --0010---00--001
+   *   ||||   ||  |||
+   *   ||||   ||  +++-- ICM:    Capture mode, on every edge.
+   *   ||||   ++------- ICI:    Interrupt on every capture event.
+   *   |+++------------ ICTSEL: Use input capture timer 4.
+   *   +--------------- ICSIDL: Input capture continues on CPU idle mode.
+   */
+  IC1CON1 = (0b001 << _IC1CON1_ICM_POSITION) | (0b00 << _IC1CON1_ICI_POSITION) |
+            (0b010 << _IC1CON1_ICTSEL_POSITION) |
+            (OFF << _IC1CON1_ICSIDL_POSITION);
+  IC1CON2 = 0x0000;
+
+  /*
+   * IC2CON1
+   *
+   * MSB
+   * --0011---00--001
+   *   ||||   ||  |||
+   *   ||||   ||  +++-- ICM:    Capture mode, on every edge.
+   *   ||||   ++------- ICI:    Interrupt on every capture event.
+   *   |+++------------ ICTSEL: Use input capture timer 5.
+   *   +--------------- ICSIDL: Input capture continues on CPU idle mode.
+   */
+  IC2CON1 = (0b001 << _IC2CON1_ICM_POSITION) | (0b00 << _IC2CON1_ICI_POSITION) |
+            (0b011 << _IC2CON1_ICTSEL_POSITION) |
+            (OFF << _IC2CON1_ICSIDL_POSITION);
+  IC2CON2 = 0x0000;
+
+#else
+
+  /* Setup timer 2 as a free running 32 bits timer. */
+  T2CON = 0x0000;
+  PR3 = 0xFFFF;
+  PR2 = 0xFFFF;
+  TMR3HLD = 0x0000;
+  TMR2 = 0x0000;
+
+  /*
+   * T2CON
+   *
+   * MSB
+   * 1-0------001-0-
+   * | |      ||| |
+   * | |      ||| +--- TCS:   Internal clock (FOSC/2).
+   * | |      ||+----- T32:   TIMER2 is bound with TIMER3 for 32 bit mode.
+   * | |      ++------ TCKPS: 1:1 Prescaler.
+   * | +-------------- TSIDL: Continue module operation in idle mode.
+   * +---------------- TON:   Timer ON.
+   */
+  T2CON = (ON << _T2CON_TON_POSITION) | (ON << _T2CON_T32_POSITION);
+
+  /*
+   * IC1CON
+   *
+   * MSB
+   * --0-----100--001
+   *   |     |||  |||
+   *   |     |||  +++-- ICM:    Capture every edge.
+   *   |     |++------- ICI:    Interrupt on every capture event.
+   *   |     +--------- ICTMR:  TMR2 contents are captured on event.
+   *   +--------------- ICSIDL: Input capture continues on CPU idle.
+   */
+  IC1CON = (0b001 << _IC1CON_ICM_POSITION) | (0b00 << _IC1CON_ICI_POSITION) |
+           (ON << _IC1CON_ICTMR_POSITION) | (OFF << _IC1CON_ICSIDL_POSITION);
+
+  /*
+   * IC2CON
+   *
+   * MSB
+   * --0-----000--001
+   *   |     |||  |||
+   *   |     |||  +++-- ICM:    Capture every edge.
+   *   |     |++------- ICI:    Interrupt on every capture event.
+   *   |     +--------- ICTMR:  TMR3 contents are captured on event.
+   *   +--------------- ICSIDL: Input capture continues on CPU idle.
+   */
+  IC2CON = (0b001 << _IC2CON_ICM_POSITION) | (0b00 << _IC2CON_ICI_POSITION) |
+           (OFF << _IC2CON_ICTMR_POSITION) | (OFF << _IC2CON_ICSIDL_POSITION);
+
+#endif /* BUSPIRATEV4 */
+
+  previous_timestamp = 0;
+  shortest_interval = 0;
+
+  for (index = 0; index < edges; index++) {
+
+    /* Wait for an edge, bailing out if the user asked so. */
+    while (UART_IC1_BUFFER_NOT_EMPTY == OFF) {
+      if (user_serial_ready_to_read()) {
+        user_serial_read_byte();
+        goto stop_capture;
+      }
+    }
+
+    /*
+     * IC1 holds the lower and IC2 the upper half of the same 32 bits timer
+     * value, captured on the same edge.  If the capture FIFOs overflow some
+     * edges are lost, which can only make the measured intervals longer.
+     */
+    current_timestamp = IC1BUF;
+    current_timestamp |= (uint32_t)IC2BUF << 16;
+
+    if ((index > 0) &&
+        ((shortest_interval == 0) ||
+         (current_timestamp - previous_timestamp < shortest_interval))) {
+      shortest_interval = current_timestamp - previous_timestamp;
+    }
+
+    previous_timestamp = current_timestamp;
+  }
+
+stop_capture:
+
+#if defined(BUSPIRATEV4)
+  IC1CON1 = 0x0000;
+  IC2CON1 = 0x0000;
+  T4CON = 0x0000;
+#else
+  IC1CON = 0x0000;
+  IC2CON = 0x0000;
+  T2CON = 0x0000;
+#endif /* BUSPIRATEV4 */
+
+  /* Remove input capture pin assignments. */
+  RPINR7bits.IC1R = 0b11111;
+  RPINR7bits.IC2R = 0b11111;
+
+  return shortest_interval;
+}
+
+uint32_t uart_lock_baud_rate(const bool quiet) {
+  uint32_t bit_time;
+  uint16_t brg_value;
+
+  if (!quiet) {
+    BPMSG1280;
+  }
+
+  bit_time = uart_measure_bit_time(UART_AUTO_BAUD_LOCK_EDGES_COUNT);
+
+  /*
+   * With BRGH set, the baud rate is FCY / (4 * (U2BRG + 1)), so anything
+   * shorter than four FCY ticks or longer than what a 16 bits U2BRG allows
+   * (a very slow or noisy line) cannot be generated.
+   */
+  if ((bit_time < 4) || (bit_time > UART_AUTO_BAUD_MAXIMUM_BIT_TIME)) {
+    uart2_setup(U2BRG, mode_configuration.high_impedance,
+                uart_settings.receive_polarity, uart_settings.databits_parity,
+                uart_settings.stop_bits);
+
+    if (!quiet) {
+      BPMSG1281;
+    }
+
+    return 0;
+  }
+
+  /* Round to the nearest baud rate generator value. */
+  brg_value = ((bit_time + 2) / 4) - 1;
+  uart2_setup(brg_value, mode_configuration.high_impedance,
+              uart_settings.receive_polarity, uart_settings.databits_parity,
+              uart_settings.stop_bits);
+
+  if (!quiet) {
+    BPMSG1283;
+    bp_write_dec_dword(FCY / bit_time);
+    BPMSG1285;
+    MSG_UART_BRG_LOCKED;
+    bp_write_dec_word(brg_value);
+    bpBR;
+  }
+
+  return FCY / bit_time;
+}
+
 /*
 databits and parity (2bits)
 1. 8, NONE *default \x0D\x0A 2. 8, EVEN \x0D\x0A 3. 8, ODD \x0D\x0A 4. 9, NONE
@@ -693,6 +976,8 @@ peripheral settings
 # 00000001 � mode version string (ART1)
 # 00000010 � UART start echo uart RX
 # 00000011 � UART stop echo uart RX
+# 00000100 - UART speed auto detection, replies 0x01 then either 0x01 and the
+             locked BRG (BRGH, BRGL) or 0x00 if stopped by the host (any byte)
 # 00000111 - UART speed manual config, 2 bytes (BRGH, BRGL)
 # 00001111 - bridge mode (reset to exit)
 # 0001xxxx � Bulk transfer, send 1-16 bytes (0=1byte!)
@@ -762,6 +1047,20 @@ void binUART(void) {
         REPORT_IO_SUCCESS();
         break;
         
+      case 4:
+        REPORT_IO_SUCCESS();
+        uart2_disable();
+        if (uart_lock_baud_rate(true) > 0) {
+          brg_value = U2BRG;
+          REPORT_IO_SUCCESS();
+          user_serial_transmit_character(HI8(brg_value));
+          user_serial_transmit_character(LO8(brg_value));
+        } else {
+          REPORT_IO_FAILURE();
+        }
+        uart2_enable();
+        break;
+
       case 7:
         REPORT_IO_SUCCESS();
         uart2_disable();
@@ -778,6 +1077,10 @@ void binUART(void) {
       case 15:
         REPORT_IO_SUCCESS();
         U2STAbits.OERR = OFF;
+
+        /* Received bytes bypass the transmission queue, flush it first. */
+        user_serial_wait_transmission_done();
+
         for (;;) {
 
 #ifdef BUSPIRATEV4
@@ -0,0 +1,269 @@
+#!/usr/bin/env python3
+#
+# SUMP/OLS protocol conformance test for the Bus Pirate logic analyzer.
+#
+# Talks to the SUMP mode of the firmware over a serial port (a Bus Pirate or
+# any pty exposing the same protocol) and checks the replies the OpenBench
+# Logic Sniffer client relies on:
+#
+#  - 5 x reset then 0x02 identifies as "1ALS";
+#  - 0x04 metadata is well formed and carries the mandatory keys;
+#  - unknown short commands are ignored;
+#  - a capture returns exactly the read count worth of samples;
+#  - run length encoded captures decode cleanly;
+#  - XOFF/XON pause and resume sample transmission, reset aborts it.
+#
+# Released into the Public Domain or CC0, your choice.
+#
+# Usage: sump_conformance.py /dev/ttyUSB0 [--baud 115200]
+#
+# Needs pyserial.  Leave the probes alone (or tied to fixed levels) while
+# the test runs.
+
+import argparse
+import struct
+import sys
+import time
+
+import serial
+
+SUMP_RESET = 0x00
+SUMP_RUN = 0x01
+SUMP_ID = 0x02
+SUMP_DESC = 0x04
+SUMP_XON = 0x11
+SUMP_XOFF = 0x13
+SUMP_DIV = 0x80
+SUMP_CNT = 0x81
+SUMP_FLAGS = 0x82
+
+SUMP_FLAGS_RLE_ENABLE = 0x01
+SUMP_RLE_COUNT_FLAG = 0x80
+
+# SUMP dividers are expressed against a 100MHz clock.
+SUMP_CLOCK = 100000000
+
+
+class ConformanceError(Exception):
+    pass
+
+
+def check(condition, message):
+    if not condition:
+        raise ConformanceError(message)
+
+
+class Sump(object):
+    def __init__(self, port):
+        self.port = port
+
+    def send(self, *values):
+        self.port.write(bytes(values))
+        self.port.flush()
+
+    def long_command(self, command, parameter):
+        self.port.write(bytes([command]) + struct.pack("<I", parameter))
+        self.port.flush()
+
+    def read(self, count, timeout=2.0):
+        data = b""
+        deadline = time.time() + timeout
+        while len(data) < count and time.time() < deadline:
+            data += self.port.read(count - len(data))
+        return data
+
+    def drain(self, quiet=0.2):
+        """Reads whatever arrives until the line stays quiet."""
+        data = b""
+        while True:
+            self.port.timeout = quiet
+            chunk = self.port.read(4096)
+            self.port.timeout = 0.1
+            if not chunk:
+                return data
+            data += chunk
+
+    def enter(self):
+        """Resets the analyzer and enters SUMP mode, returning the ID."""
+        self.send(*([SUMP_RESET] * 5))
+        time.sleep(0.1)
+        self.drain()
+        self.send(SUMP_ID)
+        return self.read(4)
+
+    def configure(self, rate, read_count, delay_count, flags=0):
+        self.long_command(SUMP_DIV, SUMP_CLOCK // rate - 1)
+        self.long_command(
+            SUMP_CNT, ((read_count // 4 - 1) & 0xFFFF)
+            | (((delay_count // 4 - 1) & 0xFFFF) << 16))
+        self.long_command(SUMP_FLAGS, flags << 8)
+
+
+def parse_metadata(data):
+    """Parses a metadata reply, returns the keys found and the bytes used."""
+    keys = {}
+    index = 0
+    while True:
+        check(index < len(data), "metadata is not terminated by key 0x00")
+        key = data[index]
+        index += 1
+        if key == 0x00:
+            return keys, index
+        if key < 0x20:
+            end = data.find(b"\0", index)
+            check(end >= 0, "metadata string 0x%02X is not terminated" % key)
+            keys[key] = data[index:end].decode("utf-8")
+            index = end + 1
+        elif key < 0x40:
+            check(index + 4 <= len(data),
+                  "metadata value 0x%02X is truncated" % key)
+            keys[key] = struct.unpack(">I", data[index:index + 4])[0]
+            index += 4
+        elif key < 0x60:
+            check(index < len(data), "metadata value 0x%02X is truncated" % key)
+            keys[key] = data[index]
+            index += 1
+        else:
+            raise ConformanceError("unknown metadata key type 0x%02X" % key)
+
+
+def decode_rle(entries):
+    """Expands run length encoded entries into samples."""
+    samples = []
+    for entry in entries:
+        if entry & SUMP_RLE_COUNT_FLAG:
+            check(samples, "RLE stream starts with a count")
+            samples.extend([samples[-1]] * (entry & ~SUMP_RLE_COUNT_FLAG))
+        else:
+            samples.append(entry)
+    return samples
+
+
+def test_identify(sump, state):
+    device_id = sump.enter()
+    check(device_id == b"1ALS", "ID reply is %r, expected '1ALS'" % device_id)
+
+
+def test_metadata(sump, state):
+    sump.enter()
+    sump.send(SUMP_DESC)
+    data = sump.drain()
+    keys, used = parse_metadata(data)
+    check(used == len(data), "%d stray bytes after metadata" % (len(data) - used))
+    check(0x01 in keys, "device name (0x01) missing")
+    check(keys.get(0x21, 0) > 0, "sample memory (0x21) missing or zero")
+    check(keys.get(0x23, 0) > 0, "maximum sample rate (0x23) missing or zero")
+    probes = keys.get(0x40, keys.get(0x20))
+    check(probes in (4, 5, 8), "probe count is %r" % probes)
+    version = keys.get(0x41, keys.get(0x24))
+    check(version == 2, "protocol version is %r, expected 2" % version)
+    state["probes"] = probes
+    state["memory"] = keys[0x21]
+    print("  %s, %d probes, %d bytes, %dHz" % (keys[0x01], probes, keys[0x21],
+                                               keys[0x23]))
+
+
+def test_unknown_command(sump, state):
+    sump.enter()
+    sump.send(0x05, 0x0F, 0x7F)
+    check(sump.drain() == b"", "unknown short commands got a reply")
+    sump.send(SUMP_ID)
+    device_id = sump.read(4)
+    check(device_id == b"1ALS", "ID after unknown commands is %r" % device_id)
+
+
+def test_capture(sump, state):
+    sump.enter()
+    sump.configure(1000000, 64, 64)
+    sump.send(SUMP_RUN)
+    samples = sump.read(64)
+    check(len(samples) == 64, "capture sent %d samples, expected 64"
+          % len(samples))
+    check(sump.drain() == b"", "capture sent more than the read count")
+    if state.get("probes") == 5:
+        check(all(sample < 0x20 for sample in samples),
+              "samples carry bits beyond the 5 probes")
+
+
+def test_rle_capture(sump, state):
+    sump.enter()
+    sump.configure(1000000, 64, 64, SUMP_FLAGS_RLE_ENABLE)
+    sump.send(SUMP_RUN)
+    entries = sump.read(64)
+    check(len(entries) == 64, "RLE capture sent %d entries, expected 64"
+          % len(entries))
+    check(sump.drain() == b"", "RLE capture sent more than the read count")
+    if state.get("probes") == 8:
+        # Channel 7 doubles as the count flag, nothing else to check.
+        return
+    samples = decode_rle(reversed(entries))
+    check(len(samples) >= 64, "RLE capture decodes to %d samples"
+          % len(samples))
+    print("  64 entries decode to %d samples" % len(samples))
+
+
+def test_flow_control(sump, state):
+    sump.enter()
+    # 256 samples at 10kHz, so XOFF lands before transmission starts.
+    sump.configure(10000, 256, 256)
+    sump.send(SUMP_RUN, SUMP_XOFF)
+    check(sump.drain(0.5) == b"", "samples were sent while paused")
+    sump.send(SUMP_XON)
+    samples = sump.read(256)
+    check(len(samples) == 256, "resumed capture sent %d samples, expected 256"
+          % len(samples))
+    check(sump.drain() == b"", "resumed capture sent more than the read count")
+
+
+def test_reset_aborts(sump, state):
+    sump.enter()
+    sump.configure(10000, 256, 256)
+    sump.send(SUMP_RUN, SUMP_XOFF)
+    time.sleep(0.2)
+    sump.send(SUMP_RESET)
+    check(sump.drain(0.5) == b"", "samples were sent after a reset")
+    device_id = sump.enter()
+    check(device_id == b"1ALS", "ID after an aborted capture is %r"
+          % device_id)
+
+
+TESTS = [
+    ("identify", test_identify),
+    ("metadata", test_metadata),
+    ("unknown short commands", test_unknown_command),
+    ("capture read count", test_capture),
+    ("RLE capture", test_rle_capture),
+    ("XOFF/XON flow control", test_flow_control),
+    ("reset aborts transmission", test_reset_aborts),
+]
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="SUMP/OLS protocol conformance test.")
+    parser.add_argument("device", help="serial port or pty to test")
+    parser.add_argument("--baud", type=int, default=115200)
+    arguments = parser.parse_args()
+
+    port = serial.Serial(arguments.device, arguments.baud, timeout=0.1)
+    sump = Sump(port)
+    state = {}
+    failures = 0
+
+    for name, test in TESTS:
+        try:
+            test(sump, state)
+            print("PASS %s" % name)
+        except ConformanceError as error:
+            print("FAIL %s: %s" % (name, error))
+            failures += 1
+
+    # Leave SUMP mode.
+    sump.send(*([SUMP_RESET] * 5))
+    port.close()
+
+    return 1 if failures else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())